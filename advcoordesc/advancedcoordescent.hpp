@@ -19,15 +19,19 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <stdexcept>
 #include <common/bbsolver.hpp>
+#include <common/deltaobj.hpp>
 #include <common/vec.hpp>
+#include <common/fixedvec.hpp>
 
 namespace panther {
 
     /**
      * An adaptive advanced coordinate descent solver
+     * @param N the number of variables if it is known at compile time, 0 otherwise
      */
-    template <class T> class AdvancedCoorDescent : public BlackBoxSolver <T> {
+    template <class T, int N = 0> class AdvancedCoorDescent : public BlackBoxSolver <T> {
     public:
 
         struct Options {
@@ -39,10 +43,142 @@ namespace panther {
             T mDec = 0.5;
             // Minimal step size
             T mMinStep = 1e-3;
+            // Evaluate x + h and x - h concurrently by OpenMP threads (the objective should be thread-safe)
+            // and take the better one if both are successful. Every trial opens a parallel region for two points,
+            // so this pays off only for objectives that are much more expensive than the fork and join of threads
+            // (microseconds); trials along different coordinates are not batched as each one starts from the result of the previous one
+            bool mConcurrentProbes = false;
         } mOptions;
 
-        T search(int n, T* x, const T * const a, const T * const b, const std::function<T(const T * const)> &f) override {
-            std::vector<T> sft(n, mOptions.mInitStep);
+        using BlackBoxSolver<T>::search;
+
+        T search(int dim, T* x, const T * const a, const T * const b, const std::function<T(const T * const)> &func) override {
+            PANTHER_STATS_DO(this->mStats.reset());
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            const std::function<T(const T * const)> f = this->instrument(dim, func);
+            const int n = snowgoose::checkDim<N>(dim);
+            T v = f(x);
+            if (mOptions.mConcurrentProbes) {
+                /* probe points for the concurrent mode: copies of x that differ only while probing */
+                std::vector<T> probes(x, x + n);
+                probes.insert(probes.end(), x, x + n);
+                T pv[2];
+                const auto pf = BlackBoxSolver<T>::parallelBatchify(n, f);
+                descend(n, [&](int i, T h) {
+                    const T xp = std::min(x[i] + h, b[i]);
+                    const T xm = std::max(xp - 2 * h, a[i]);
+                    probes[i] = xp;
+                    probes[n + i] = xm;
+                    pf(2, probes.data(), pv);
+                    /* ties are resolved in favor of x + h as in the serial mode */
+                    const int k = (pv[1] < pv[0]) ? 1 : 0;
+                    const bool success = pv[k] < v;
+                    if (success) {
+                        v = pv[k];
+                        x[i] = (k == 0) ? xp : xm;
+                    }
+                    probes[i] = x[i];
+                    probes[n + i] = x[i];
+                    return success;
+                });
+            } else {
+                descend(n, [&](int i, T h) {
+                    const T xi = x[i];
+                    x[i] = std::min(xi + h, b[i]);
+                    T vn = f(x);
+                    if (vn < v) {
+                        v = vn;
+                        return true;
+                    }
+                    x[i] = std::max(x[i] - 2 * h, a[i]);
+                    vn = f(x);
+                    if (vn < v) {
+                        v = vn;
+                        return true;
+                    }
+                    x[i] = xi;
+                    return false;
+                });
+            }
+            return v;
+        }
+
+        /**
+         * Searches for a minimum of an objective that supports incremental updates
+         * Each trial costs a single probe() instead of a full evaluation.
+         * The concurrent probes option is ignored in this mode. Values of probes are not kept in the cache,
+         * so the search throws std::invalid_argument if a cache is set.
+         * @param dim the number of parameters
+         * @param x starting point on entry, result on exit
+         * @param a lower bounds on variables
+         * @param b upper bounds on variables
+         * @param f the incremental objective
+         * @return the found value
+         */
+        T search(int dim, T* x, const T * const a, const T * const b, DeltaObjective<T> &f) {
+            PANTHER_STATS_DO(this->mStats.reset());
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            if (this->mCache)
+                throw std::invalid_argument("the cache of values can't be used with an incremental objective");
+            const int n = snowgoose::checkDim<N>(dim);
+            T v;
+            {
+                PANTHER_STATS_TIMER(this->mStats.mFuncTime);
+                PANTHER_STATS_DO(this->mStats.mEvals++; this->mStats.mCalls++);
+                if (this->mControl != nullptr)
+                    this->mControl->addEvals(1);
+                v = f.init(n, x);
+            }
+            auto probe = [&](int i, T xn) {
+                PANTHER_STATS_TIMER(this->mStats.mFuncTime);
+                PANTHER_STATS_DO(this->mStats.mEvals++; this->mStats.mCalls++);
+                if (this->mControl != nullptr)
+                    this->mControl->addEvals(1);
+                return f.probe(i, x[i], xn);
+            };
+            auto accept = [&](int i, T xn, T vn) {
+                f.accept(i, x[i], xn);
+                x[i] = xn;
+                v = vn;
+            };
+            descend(n, [&](int i, T h) {
+                const T xp = std::min(x[i] + h, b[i]);
+                T vn = probe(i, xp);
+                if (vn < v) {
+                    accept(i, xp, vn);
+                    return true;
+                }
+                const T xm = std::max(xp - 2 * h, a[i]);
+                vn = probe(i, xm);
+                if (vn < v) {
+                    accept(i, xm, vn);
+                    return true;
+                }
+                return false;
+            });
+            return v;
+        }
+
+        /**
+         * Searches for a minimum of an incremental objective within the limits of the control
+         * Every probe counts as an evaluation.
+         */
+        T search(int dim, T* x, const T * const a, const T * const b, DeltaObjective<T> &f, panther::SearchControl& ctl) {
+            typename BlackBoxSolver<T>::ControlScope scope(*this, ctl);
+            return search(dim, x, a, b, f);
+        }
+
+    private:
+
+        /**
+         * Step adaptation loop shared by all modes, stops when the limits of the search are reached
+         * @param n the number of parameters
+         * @param trial tries to improve the i-th coordinate with the step h, returns true on success
+         */
+        template <class Trial> void descend(int n, Trial trial) {
+            snowgoose::VecStorage<T, N> sft;
+            sft.resize(n);
+            snowgoose::VecOps<N>::vecSet(n, mOptions.mInitStep, sft.data());
             auto maxStep = [&sft, n]() {
                 T rv = 0;
                 for (int i = 0; i < n; i++) {
@@ -50,35 +186,19 @@ namespace panther {
                 }
                 return rv;
             };
-            T v = f(x);
             while (maxStep() >= mOptions.mMinStep) {
                 for (int i = 0; i < n; i++) {
-                    const T h = sft[i];
-                    const T xi = x[i];
-                    x[i] = std::min(x[i] + h, b[i]);
-                    T vn = f(x);
-                    if (vn < v) {
-                        v = vn;
+                    if (this->stopped())
+                        return;
+                    if (trial(i, sft[i])) {
                         sft[i] *= mOptions.mInc;
                     } else {
-                        x[i] = std::max(x[i] - 2 * h, a[i]);
-                        vn = f(x);
-                        if (vn < v) {
-                            v = vn;
-                            sft[i] *= mOptions.mInc;
-                        } else {
-                            x[i] = xi;
-                            sft[i] *= mOptions.mDec;
-                        }
+                        sft[i] *= mOptions.mDec;
                     }
                 }
             }
-            return v;
         }
 
-    private:
-
-
     };
 }
 
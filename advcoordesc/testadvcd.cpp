@@ -12,6 +12,10 @@
  */
 #include <iostream>
 #include <iterator>
+#include <stdexcept>
+#include <cmath>
+#include <thread>
+#include <chrono>
 #include "advancedcoordescent.hpp"
 
 constexpr int n = 3;
@@ -26,16 +30,57 @@ constexpr int n = 3;
 struct F {
 
     double operator()(const double *x) {
-        double v;
-        mCnt ++;
+        double v = 0;
         for (int i = 0; i < n; i++)
             v += x[i] * x[i];
         return v;
     }
-    
-    int mCnt = 0;
 };
 
+/**
+ * Separable sum of squares with O(1) updates
+ */
+struct DF : public DeltaObjective<double> {
+    double mV;
+
+    double init(int n, const double* x) override {
+        mV = 0;
+        for (int i = 0; i < n; i++)
+            mV += x[i] * x[i];
+        return mV;
+    }
+
+    double probe(int i, double xold, double xnew) override {
+        return mV - xold * xold + xnew * xnew;
+    }
+
+    void accept(int i, double xold, double xnew) override {
+        mV = probe(i, xold, xnew);
+    }
+};
+
+/* the objective slowed down to test the time limits */
+double slow(const double* x) {
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+    return F()(x);
+}
+
+using Control = panther::SearchControl;
+
+int fails = 0;
+
+void check(bool ok, const char* what) {
+    std::cout << what << ": " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
+/* checks that the control stopped the search for the reason within the budget plus slack evaluations */
+void checkStopped(const Control& ctl, Control::Reason reason, long long slack, double v, const double* x, const char* what) {
+    const bool ok = (ctl.reason() == reason) && ((ctl.mMaxEvals == 0) || (ctl.evals() <= ctl.mMaxEvals + slack)) && (F()(x) == v);
+    std::cout << what << ": " << v << " after " << ctl.evals() << " evaluations " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
 /*
  * 
  */
@@ -52,9 +97,162 @@ int main(int argc, char** argv) {
     std::cout << "Found " << v << " at [";
     std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
     std::cout << "]\n";
-    std::cout << f.mCnt << " function calls done\n";
+    std::cout << adv.getStats().toString();
+    const double vfull = v;
+    double xfull[n];
+    std::copy(x, x + n, xfull);
 
+    /* the dimension known at compile time gives the same result */
+    panther::AdvancedCoorDescent<double, n> fixed;
+    double y[n];
+    std::fill(y, y + n, 1);
+    check(fixed.search(n, y, a, b, std::ref(f)) == v && std::equal(x, x + n, y), "fixed dimension");
+
+    /* x + h and x - h can't be both successful on a sum of squares, so the trajectory is the serial one */
+    panther::AdvancedCoorDescent<double> conc;
+    conc.mOptions.mConcurrentProbes = true;
+    std::fill(y, y + n, 1);
+    const double vc = conc.search(n, y, a, b, std::ref(f));
+    std::cout << "Found with concurrent probes " << vc << "\n";
+    check(vc == v && std::equal(x, x + n, y), "concurrent probes");
+
+    /* steps are powers of two, so trials return to the lattice points visited before */
+    adv.mOptions.mInitStep = 0.25;
+    adv.mOptions.mInc = 1;
+    std::fill(x, x + n, 1);
+    const double vlat = adv.search(n, x, a, b, std::ref(f));
+    auto cache = std::make_shared<panther::EvalCache<double>>(n, 1024);
+    adv.setCache(cache);
+    std::fill(x, x + n, 1);
+    v = adv.search(n, x, a, b, std::ref(f));
+    std::cout << "Found with cache " << v << " at [";
+    std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
+    std::cout << "]\n";
+    std::cout << adv.getStats().toString();
+    check(cache->hits() > 0, "cache hits on revisited points");
+    check(v == vlat && v == f(x), "cached search finds the same value");
+    bool same = true;
+    for (double y0 = -1; y0 <= 1; y0 += 0.25)
+        for (double y1 = -1; y1 <= 1; y1 += 0.25)
+            for (double y2 = -1; y2 <= 1; y2 += 0.25) {
+                const double y[n] = {y0, y1, y2};
+                double cv;
+                if (cache->lookup(y, cv))
+                    same = same && (cv == f(y));
+            }
+    check(same, "cached values equal direct evaluations");
+
+    /* the second search shares the cache and finds all points there */
+    const long long misses = cache->misses();
+    std::fill(x, x + n, 1);
+    v = adv.search(n, x, a, b, std::ref(f));
+    check(v == vlat && cache->misses() == misses, "repeated search is served by the cache");
+
+    /* blocks of points partly found in the cache */
+    double pts[4 * n] = {1, 1, 1, 7, 7, 7, 0, 0, 0, 8, 8, 8}, pv[4];
+    int called = 0;
+    const int k = cache->evaluate(4, pts, pv, [&](int m, const double* y, double* w) {
+        called += m;
+        for (int i = 0; i < m; i++)
+            w[i] = f(y + i * n);
+    });
+    bool blockOk = (k == called);
+    for (int i = 0; i < 4; i++)
+        blockOk = blockOk && (pv[i] == f(pts + i * n));
+    check(blockOk && k == 2, "block evaluation passes only missed points");
+
+    /* a cache smaller than the number of visited points evicts them */
+    auto small = std::make_shared<panther::EvalCache<double>>(n, 8);
+    adv.setCache(small);
+    std::fill(x, x + n, 1);
+    v = adv.search(n, x, a, b, std::ref(f));
+    check(v == vlat && small->size() == 8 && small->misses() > 8, "small cache evicts points");
+    same = true;
+    for (double y0 = -1; y0 <= 1; y0 += 0.25)
+        for (double y1 = -1; y1 <= 1; y1 += 0.25)
+            for (double y2 = -1; y2 <= 1; y2 += 0.25) {
+                const double y[n] = {y0, y1, y2};
+                double cv;
+                if (small->lookup(y, cv))
+                    same = same && (cv == f(y));
+            }
+    check(same, "values are kept after evictions");
+
+    /* the cache should keep points of the problem dimension */
+    adv.setCache(std::make_shared<panther::EvalCache<double>>(n - 1, 1024));
+    bool thrown = false;
+    try {
+        adv.search(n, x, a, b, std::ref(f));
+    } catch (std::invalid_argument& e) {
+        thrown = true;
+    }
+    check(thrown, "cache of another dimension is rejected");
+    adv.setCache(nullptr);
+    adv.mOptions = decltype(adv.mOptions)();
+
+    std::fill(x, x + n, 1);
+    DF df;
+    v = adv.search(n, x, a, b, df);
+    std::cout << "Found with delta objective " << v << " at [";
+    std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
+    std::cout << "]\n";
+    std::cout << adv.getStats().toString();
+    /* the value is updated incrementally, so rounding errors of the terms (about 1) accumulate in it */
+    check(std::equal(x, x + n, xfull) && std::abs(v - vfull) < 1e-12, "delta objective finds the same point");
+
+    adv.setCache(std::make_shared<panther::EvalCache<double>>(n, 1024));
+    thrown = false;
+    try {
+        adv.search(n, x, a, b, df);
+    } catch (std::invalid_argument& e) {
+        thrown = true;
+    }
+    check(thrown, "cache is rejected with a delta objective");
+    adv.setCache(nullptr);
+
+    /* the search stops between coordinates, concurrent probes evaluate two points */
+    panther::AdvancedCoorDescent<double> lim;
+    Control count;
+    std::fill(x, x + n, 1);
+    lim.search(n, x, a, b, std::ref(f), count);
+    Control ctl;
+    ctl.mMaxEvals = count.evals() / 2;
+    std::fill(x, x + n, 1);
+    v = lim.search(n, x, a, b, std::ref(f), ctl);
+    checkStopped(ctl, Control::BUDGET, 1, v, x, "budget");
+    lim.mOptions.mConcurrentProbes = true;
+    ctl.reset();
+    std::fill(x, x + n, 1);
+    v = lim.search(n, x, a, b, std::ref(f), ctl);
+    checkStopped(ctl, Control::BUDGET, 2, v, x, "budget with concurrent probes");
+    lim.mOptions.mConcurrentProbes = false;
+
+    /* the slow search takes a fraction of a second */
+    Control deadline;
+    deadline.setTimeLimit(0.02);
+    std::fill(x, x + n, 1);
+    v = lim.search(n, x, a, b, slow, deadline);
+    checkStopped(deadline, Control::DEADLINE, 0, v, x, "deadline");
+
+    Control cancel;
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cancel.cancel();
+    });
+    std::fill(x, x + n, 1);
+    v = lim.search(n, x, a, b, slow, cancel);
+    canceller.join();
+    checkStopped(cancel, Control::CANCELLED, 0, v, x, "cancelled by another thread");
+
+    /* the incremental objective counts every probe */
+    Control delta;
+    delta.mMaxEvals = count.evals() / 2;
+    std::fill(x, x + n, 1);
+    v = lim.search(n, x, a, b, df, delta);
+    /* the value is updated incrementally, so it is compared with a tolerance as above */
+    check((delta.reason() == Control::BUDGET) && (delta.evals() <= delta.mMaxEvals + 1) && std::abs(f(x) - v) < 1e-12,
+            "budget of the delta search");
 
-    return 0;
+    return fails ? 1 : 0;
 }
 
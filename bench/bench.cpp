@@ -0,0 +1,129 @@
+/* 
+ * File:   bench.cpp
+ *
+ * Benchmark of solvers on standard test functions.
+ *
+ * Usage: bench.exe [-t tolerance] [-g maximal dimension for GridLip] [dimension ...]
+ *
+ * Prints a CSV table, one line per solver, function and dimension:
+ * solver,function,dim,value,min,evals,time,evals_per_sec,overhead,time_to_target,evals_to_target
+ * where the target is min + tolerance, time_to_target and evals_to_target are -1 if it was not reached.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <brute/bruteforce.hpp>
+#include <gridlip/gridlip.hpp>
+#include <advcoordesc/advancedcoordescent.hpp>
+#include <rosenbrock/rosenbrockmethod.hpp>
+#include <multistart/multistart.hpp>
+#include "testfuncs.hpp"
+
+using Solver = BlackBoxSolver<double>;
+
+/**
+ * A solver to benchmark
+ */
+struct SolverSetup {
+    std::string mName;
+    /* makes the solver for the dimension and the function */
+    std::function<std::unique_ptr<Solver>(int, const panther::TestFunction&) > mMake;
+    /* the maximal dimension to run the solver for */
+    int mMaxDim;
+};
+
+int main(int argc, char** argv) {
+    double tol = 1e-2;
+    int gmax = 2;
+    std::vector<int> dims;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && (i + 1 < argc))
+            tol = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-g") && (i + 1 < argc))
+            gmax = atoi(argv[++i]);
+        else
+            dims.push_back(atoi(argv[i]));
+    }
+    if (dims.empty())
+        dims = {2, 4, 8};
+
+    std::vector<SolverSetup> solvers;
+    solvers.push_back({"bruteforce", [](int n, const panther::TestFunction&) {
+            /* about 10^5 mesh points */
+            const int p = std::max(2, (int) pow(1e5, 1. / n));
+            return std::unique_ptr<Solver>(new panther::BruteForce<double>(p));
+        }, 16});
+    solvers.push_back({"gridlip", [tol](int n, const panther::TestFunction&) {
+            auto s = new panther::GridLip<double>();
+            s->mOptions.mEps = tol;
+            s->mOptions.mEngine = panther::GridLip<double>::BEST_FIRST;
+            return std::unique_ptr<Solver>(s);
+        }, gmax});
+    solvers.push_back({"advcoordesc", [](int n, const panther::TestFunction & tf) {
+            auto s = new panther::AdvancedCoorDescent<double>();
+            s->mOptions.mInitStep = 0.1 * (tf.mB - tf.mA);
+            s->mOptions.mMinStep = 1e-6;
+            return std::unique_ptr<Solver>(s);
+        }, 1 << 20});
+    solvers.push_back({"rosenbrock", [](int n, const panther::TestFunction & tf) {
+            auto s = new panther::RosenbrockMethod<double>();
+            s->getOptions().mHInit.assign(n, 0.1 * (tf.mB - tf.mA));
+            s->getOptions().mHLB = 1e-6;
+            s->getOptions().mMinGrad = 1e-6;
+            s->getOptions().mMaxStepsNumber = 100000;
+            return std::unique_ptr<Solver>(s);
+        }, 1 << 20});
+    solvers.push_back({"multistart", [](int n, const panther::TestFunction & tf) {
+            auto s = new panther::MultiStart<double>([n, &tf]() {
+                auto ls = new panther::AdvancedCoorDescent<double>();
+                ls->mOptions.mInitStep = 0.1 * (tf.mB - tf.mA);
+                ls->mOptions.mMinStep = 1e-6;
+                return std::unique_ptr<Solver>(ls);
+            });
+            s->mOptions.mStarts = 16 * n;
+            return std::unique_ptr<Solver>(s);
+        }, 1 << 20});
+
+    std::cout.precision(10);
+    std::cout << "solver,function,dim,value,min,evals,time,evals_per_sec,overhead,time_to_target,evals_to_target\n";
+    for (int n : dims) {
+        for (auto& tf : panther::testFunctions()) {
+            std::vector<double> a(n, tf.mA), b(n, tf.mB), x(n);
+            const double fmin = tf.mMin(n);
+            const double target = fmin + tol;
+            for (auto& ss : solvers) {
+                if (n > ss.mMaxDim)
+                    continue;
+                auto solver = ss.mMake(n, tf);
+                /* local solvers start from the same point away from the center */
+                for (int i = 0; i < n; i++)
+                    x[i] = tf.mA + 0.8 * (tf.mB - tf.mA);
+                /* solvers may call the objective from several threads, the first thread reaching the target records it */
+                std::atomic<long long> evals{0}, evalsToTarget{-1};
+                double timeToTarget = -1;
+                const auto start = std::chrono::steady_clock::now();
+                auto f = [&](const double* y) {
+                    const double v = tf.mFunc(n, y);
+                    const long long e = ++evals;
+                    long long none = -1;
+                    if ((v <= target) && (evalsToTarget.load() < 0) && evalsToTarget.compare_exchange_strong(none, e))
+                        timeToTarget = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    return v;
+                };
+                const double v = solver->search(n, x.data(), a.data(), b.data(), f);
+                const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cout << ss.mName << "," << tf.mName << "," << n << "," << v << "," << fmin << ","
+                        << evals << "," << t << "," << (t > 0 ? evals / t : 0) << ","
+                        << solver->getStats().overheadTime() << ","
+                        << timeToTarget << "," << evalsToTarget << std::endl;
+            }
+        }
+    }
+    return 0;
+}
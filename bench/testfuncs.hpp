@@ -0,0 +1,129 @@
+/* 
+ * File:   testfuncs.hpp
+ *
+ * Standard test functions for global optimization of arbitrary dimension
+ */
+
+#ifndef TESTFUNCS_HPP
+#define TESTFUNCS_HPP
+
+#include <math.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <common/utilmacro.hpp>
+
+namespace panther {
+
+    /**
+     * A test problem: f(x) -> min, a <= x <= b
+     */
+    struct TestFunction {
+        /**
+         * Name of the function
+         */
+        std::string mName;
+        /**
+         * Computes the value: n, x -> f(x)
+         */
+        std::function<double(int, const double*)> mFunc;
+        /**
+         * Bounds (the same for all variables)
+         */
+        double mA, mB;
+        /**
+         * Global minimum value for the given dimension
+         */
+        std::function<double(int)> mMin;
+    };
+
+    /**
+     * Standard test functions
+     * @return the list of functions
+     */
+    inline std::vector<TestFunction> testFunctions() {
+        std::vector<TestFunction> fl;
+        auto zero = [](int) {
+            return 0.;
+        };
+
+        fl.push_back({"sphere", [](int n, const double* x) {
+                double v = 0;
+                for (int i = 0; i < n; i++)
+                    v += x[i] * x[i];
+                return v;
+            }, -5.12, 5.12, zero});
+
+        fl.push_back({"rosenbrock", [](int n, const double* x) {
+                double v = 0;
+                for (int i = 0; i < n - 1; i++) {
+                    const double u = x[i + 1] - x[i] * x[i];
+                    const double w = 1 - x[i];
+                    v += 100 * u * u + w * w;
+                }
+                return v;
+            }, -2.048, 2.048, zero});
+
+        fl.push_back({"rastrigin", [](int n, const double* x) {
+                double v = 10 * n;
+                for (int i = 0; i < n; i++)
+                    v += x[i] * x[i] - 10 * cos(2 * M_PI * x[i]);
+                return v;
+            }, -5.12, 5.12, zero});
+
+        fl.push_back({"ackley", [](int n, const double* x) {
+                double s1 = 0, s2 = 0;
+                for (int i = 0; i < n; i++) {
+                    s1 += x[i] * x[i];
+                    s2 += cos(2 * M_PI * x[i]);
+                }
+                return -20 * exp(-0.2 * sqrt(s1 / n)) - exp(s2 / n) + 20 + M_E;
+            }, -32.768, 32.768, zero});
+
+        fl.push_back({"griewank", [](int n, const double* x) {
+                double s = 0, p = 1;
+                for (int i = 0; i < n; i++) {
+                    s += x[i] * x[i];
+                    p *= cos(x[i] / sqrt(i + 1.));
+                }
+                return 1 + s / 4000 - p;
+            }, -600, 600, zero});
+
+        fl.push_back({"styblinski-tang", [](int n, const double* x) {
+                double v = 0;
+                for (int i = 0; i < n; i++) {
+                    const double y = x[i] * x[i];
+                    v += y * y - 16 * y + 5 * x[i];
+                }
+                return 0.5 * v;
+            }, -5, 5, [](int n) {
+                return -39.16616570377142 * n;
+            }});
+
+        fl.push_back({"zakharov", [](int n, const double* x) {
+                double s1 = 0, s2 = 0;
+                for (int i = 0; i < n; i++) {
+                    s1 += x[i] * x[i];
+                    s2 += 0.5 * (i + 1) * x[i];
+                }
+                return s1 + s2 * s2 + s2 * s2 * s2 * s2;
+            }, -5, 10, zero});
+
+        fl.push_back({"levy", [](int n, const double* x) {
+                auto w = [x](int i) {
+                    return 1 + (x[i] - 1) / 4;
+                };
+                const double w0 = w(0), wn = w(n - 1);
+                double v = SGSQR(sin(M_PI * w0)) + SGSQR(wn - 1) * (1 + SGSQR(sin(2 * M_PI * wn)));
+                for (int i = 0; i < n - 1; i++) {
+                    const double wi = w(i);
+                    v += SGSQR(wi - 1) * (1 + 10 * SGSQR(sin(M_PI * wi + 1)));
+                }
+                return v;
+            }, -10, 10, zero});
+
+        return fl;
+    }
+}
+
+#endif /* TESTFUNCS_HPP */
@@ -17,16 +17,53 @@
 #include <math.h>
 #include <algorithm>
 #include <limits>
+#include <vector>
 #include <common/bbsolver.hpp>
+#include <common/fixedvec.hpp>
+#include <common/lowdisc.hpp>
 
 namespace panther {
 
     /**
      * A simple rectangular mesh black-box optimizer
+     * It can also sample the box by the Halton sequence: then the search may be stopped
+     * after any number of evaluations and the points evaluated so far cover the box evenly.
+     * @param N the number of variables if it is known at compile time, 0 otherwise
      */
-    template <class T> class BruteForce : public BlackBoxSolver <T> {
+    template <class T, int N = 0> class BruteForce : public BlackBoxSolver <T> {
     public:
 
+        using BatchFunction = typename BlackBoxSolver<T>::BatchFunction;
+
+        /**
+         * Points to evaluate
+         */
+        enum Sampling {
+            /* nodes of the rectangular mesh */
+            MESH,
+            /* points of the Halton sequence */
+            HALTON
+        };
+
+        /**
+         * Called whenever the incumbent improves
+         * @param v the new incumbent value
+         * @param x the new incumbent point
+         * @param k the number of the point in the mesh or the sequence
+         */
+        using Watcher = std::function<void(T v, const T* x, long long k)>;
+
+        struct Options {
+            // Points to evaluate
+            Sampling mSampling = MESH;
+            // Number of points of the Halton sequence to evaluate (0 - as many as mesh nodes)
+            long long mMaxEvals = 0;
+            // Number of mesh points passed to the objective at once
+            int mBatchSize = 256;
+            // Sweep the mesh by several OpenMP threads (the objective should be thread-safe)
+            bool mParallel = false;
+        } mOptions;
+
         /**
          * Constructor
          * @param p number of mesh points per dimension
@@ -34,28 +71,97 @@ namespace panther {
         BruteForce(int p) : mP(p) {
         }
 
+        using BlackBoxSolver<T>::search;
+        using BlackBoxSolver<T>::searchBatch;
+
         T search(int n, T* x, const T * const a, const T * const b, const std::function<T(const T * const)> &f) override {
-            const int tot = pow(mP, n);
-            T *y = new T[n];
+            return searchBatch(n, x, a, b, BlackBoxSolver<T>::batchify(n, f));
+        }
+
+        T searchBatch(int dim, T* x, const T * const a, const T * const b, const BatchFunction &func) override {
+            PANTHER_STATS_DO(this->mStats.reset({mOptions.mSampling == HALTON ? "sampling" : "mesh"}));
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            const BatchFunction f = this->instrument(dim, func);
+            const int n = snowgoose::checkDim<N>(dim);
+            const long long nodes = pow(mP, n);
+            const long long tot = ((mOptions.mSampling == HALTON) && (mOptions.mMaxEvals > 0)) ? mOptions.mMaxEvals : nodes;
+            const int bs = std::max(1LL, std::min((long long) mOptions.mBatchSize, tot));
+            const snowgoose::Halton halton(n);
+            auto point = [&](long long k, T * y) {
+                if (mOptions.mSampling == HALTON)
+                    halton.point(k, a, b, y);
+                else
+                    meshPoint(n, k, a, b, y);
+            };
             T fr = std::numeric_limits<T>::max();
-            for (int i = 0; i < tot; i++) {
-                for (int j = 0; j < n; j++) {
-                    int I = i;
-                    y[j] = a[j] + (T) ((I - (I / mP) * mP)) * (b[j] - a[j]) / (T) mP;
-                    I = I / mP;
-                }
-                T v = f(y);
-                if (v < fr) {
-                    fr = v;
-                    std::copy(y, y + n, x);
+            long long ir = -1;
+#pragma omp parallel if (mOptions.mParallel)
+            {
+                std::vector<T> y(bs * n), v(bs);
+                /* chunks of the mesh or the sequence are generated and evaluated by threads independently */
+#pragma omp for schedule(dynamic)
+                for (long long i = 0; i < tot; i += bs) {
+                    /* the remaining chunks are skipped when a limit is reached */
+                    if (this->stopped())
+                        continue;
+                    const int m = std::min((long long) bs, tot - i);
+                    {
+                        PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[0]);
+                        for (int k = 0; k < m; k++)
+                            point(i + k, y.data() + k * n);
+                    }
+                    f(m, y.data(), v.data());
+                    /* the best point of the chunk */
+                    int kr = 0;
+                    for (int k = 1; k < m; k++) {
+                        if (v[k] < v[kr])
+                            kr = k;
+                    }
+                    /* ties are resolved in favor of the lower point number as in the serial sweep */
+#pragma omp critical(panther_bruteforce)
+                    {
+                        if ((ir < 0) || (v[kr] < fr) || ((v[kr] == fr) && (i + kr < ir))) {
+                            fr = v[kr];
+                            ir = i + kr;
+                            for (const auto& w : mWatchers)
+                                w(fr, y.data() + kr * n, ir);
+                        }
+                    }
                 }
             }
-            delete [] y;
+            if (ir >= 0)
+                point(ir, x);
             return fr;
         }
 
+        /**
+         * Retrieve watchers called when the incumbent improves (under a lock if the search is parallel)
+         * @return watchers
+         */
+        std::vector<Watcher>& getWatchers() {
+            return mWatchers;
+        }
+
     private:
         int mP;
+        std::vector<Watcher> mWatchers;
+
+        /**
+         * Computes the coordinates of the mesh point with the given number
+         * @param n dimension
+         * @param i the number of the point
+         * @param a lower bounds
+         * @param b upper bounds
+         * @param y the resulting point
+         */
+        void meshPoint(int n, long long i, const T* a, const T* b, T* y) const {
+            long long I = i;
+            const int d = (N > 0) ? N : n;
+            for (int j = 0; j < d; j++) {
+                y[j] = a[j] + (T) ((I - (I / mP) * mP)) * (b[j] - a[j]) / (T) mP;
+                I = I / mP;
+            }
+        }
 
     };
 }
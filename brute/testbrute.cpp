@@ -6,16 +6,43 @@
 
 #include <iostream>
 #include <iterator>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <chrono>
 #include "bruteforce.hpp"
 
 constexpr int n = 3;
 
 double f(const double* x) {
-    double v;
+    double v = 0;
     for(int i = 0; i < n; i ++)
         v += x[i] * x[i];
     return v;
 }
+
+/* the objective slowed down to test the time limits */
+double slow(const double* x) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    return f(x);
+}
+
+using Control = panther::SearchControl;
+
+int fails = 0;
+
+void check(bool ok, const char* what) {
+    std::cout << what << ": " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
+/* checks that the control stopped the search for the reason within the budget plus slack evaluations */
+void checkStopped(const Control& ctl, Control::Reason reason, long long slack, double v, const double* x, const char* what) {
+    const bool ok = (ctl.reason() == reason) && ((ctl.mMaxEvals == 0) || (ctl.evals() <= ctl.mMaxEvals + slack)) && (f(x) == v);
+    std::cout << what << ": " << v << " after " << ctl.evals() << " evaluations " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
 int main() {
     panther::BruteForce<double> bf(16);
     double x[n];
@@ -26,4 +53,70 @@ int main() {
     std::cout << "Found " << v << " at [" ;
     std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
     std::cout << "]\n";
+    std::cout << bf.getStats().toString();
+
+    /* the dimension known at compile time gives the same result */
+    panther::BruteForce<double, n> fixed(16);
+    double y[n];
+    double w = fixed.search(n, y, a, b, f);
+    check((w == v) && std::equal(x, x + n, y), "fixed dimension");
+
+    /* chunks of the mesh swept by threads give the serial result */
+    panther::BruteForce<double> par(16);
+    par.mOptions.mParallel = true;
+    par.mOptions.mBatchSize = 64;
+    w = par.search(n, y, a, b, f);
+    check((w == v) && std::equal(x, x + n, y), "parallel sweep");
+
+    /* points of the Halton sequence, incumbents reported by the watcher should decrease */
+    const double vmesh = v;
+    panther::BruteForce<double> hal(16);
+    hal.mOptions.mSampling = panther::BruteForce<double>::HALTON;
+    hal.mOptions.mMaxEvals = 5000;
+    double last = std::numeric_limits<double>::max();
+    bool decreasing = true;
+    hal.getWatchers().push_back([&](double u, const double* z, long long k) {
+        decreasing = decreasing && (u < last) && (f(z) == u);
+        last = u;
+    });
+    long long calls = 0;
+    v = hal.search(n, x, a, b, [&](const double* z) { calls++; return f(z); });
+    std::cout << "Found by sampling " << v << " at [" ;
+    std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
+    std::cout << "]\n";
+    std::cout << hal.getStats().toString();
+    check(decreasing && (v == last), "incumbents decrease");
+    check(calls == hal.mOptions.mMaxEvals, "sampling budget");
+    check((f(x) == v) && (v - vmesh < 1e-2), "sampling finds the minimum");
+
+    /* chunks of the sequence generated by threads give the serial result */
+    hal.mOptions.mParallel = true;
+    hal.mOptions.mBatchSize = 64;
+    last = std::numeric_limits<double>::max();
+    w = hal.search(n, y, a, b, f);
+    check(decreasing && (w == v) && std::equal(x, x + n, y), "parallel sampling");
+
+    /* the sweep stops between chunks of mBatchSize points */
+    panther::BruteForce<double> lim(16);
+    Control ctl;
+    ctl.mMaxEvals = 1000;
+    v = lim.search(n, x, a, b, f, ctl);
+    checkStopped(ctl, Control::BUDGET, lim.mOptions.mBatchSize, v, x, "budget");
+
+    /* the slow sweep takes 0.2 seconds */
+    Control deadline;
+    deadline.setTimeLimit(0.02);
+    v = lim.search(n, x, a, b, slow, deadline);
+    checkStopped(deadline, Control::DEADLINE, 0, v, x, "deadline");
+
+    lim.mOptions.mParallel = true;
+    Control cancel;
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cancel.cancel();
+    });
+    v = lim.search(n, x, a, b, slow, cancel);
+    canceller.join();
+    checkStopped(cancel, Control::CANCELLED, 0, v, x, "cancelled by another thread");
+    return fails ? 1 : 0;
 }
\ No newline at end of file
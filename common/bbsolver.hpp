@@ -9,12 +9,26 @@
 #define BBSOLVER_HPP
 
 #include <functional>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include "stats.hpp"
+#include "evalcache.hpp"
+#include "control.hpp"
 
 /**
  * Generic black box solver interface
  */
 template <class T> class BlackBoxSolver {
     public:
+        /**
+         * Batch objective: computes values for a block of points
+         * @param m the number of points in the block
+         * @param x points stored one after another (m * n values)
+         * @param v the resulting values (m values)
+         */
+        using BatchFunction = std::function<void ( int m, const T* x, T* v )>;
+
         /**
          * The method that searches for a minimum of a function with interval constraints
          * @param n the number of parameters
@@ -25,8 +39,244 @@ template <class T> class BlackBoxSolver {
          * @return the found value
          */
         virtual T search(int n, T* x, const T* a, const T* b, const std::function<T ( const T* )> &f) = 0;
+
+        /**
+         * Searches for a minimum of a function that is evaluated by blocks of points
+         * The default implementation passes points to the objective one by one
+         * @param n the number of parameters
+         * @param x starting point on entry, result on exit (for some methods may be arbitrary on entry)
+         * @param a lower (interval) bounds on variables
+         * @param b upper (interval) bounds on variables
+         * @param f the batch objective function
+         * @return the found value
+         */
+        virtual T searchBatch(int n, T* x, const T* a, const T* b, const BatchFunction &f) {
+            return search(n, x, a, b, [&f](const T* y) {
+                T v;
+                f(1, y, &v);
+                return v;
+            });
+        }
+
+        /**
+         * Searches within the limits of the control, stops when one of them is reached
+         * @param n the number of parameters
+         * @param x starting point on entry, the best point found on exit
+         * @param a lower (interval) bounds on variables
+         * @param b upper (interval) bounds on variables
+         * @param f the objective function
+         * @param ctl the limits (evaluations are counted in it)
+         * @return the best value found
+         */
+        T search(int n, T* x, const T* a, const T* b, const std::function<T ( const T* )> &f, panther::SearchControl& ctl) {
+            ControlScope scope(*this, ctl);
+            return search(n, x, a, b, f);
+        }
+
+        /**
+         * Searches within the limits of the control, the objective is evaluated by blocks of points
+         * @param n the number of parameters
+         * @param x starting point on entry, the best point found on exit
+         * @param a lower (interval) bounds on variables
+         * @param b upper (interval) bounds on variables
+         * @param f the batch objective function
+         * @param ctl the limits (evaluations are counted in it)
+         * @return the best value found
+         */
+        T searchBatch(int n, T* x, const T* a, const T* b, const BatchFunction &f, panther::SearchControl& ctl) {
+            ControlScope scope(*this, ctl);
+            return searchBatch(n, x, a, b, f);
+        }
+
+        /**
+         * Makes a batch objective that evaluates the given function point by point
+         * @param n the number of parameters
+         * @param f the objective function (should outlive the result)
+         * @return the batch objective
+         */
+        static BatchFunction batchify(int n, const std::function<T ( const T* )> &f) {
+            return [n, &f](int m, const T* x, T* v) {
+                for (int i = 0; i < m; i++)
+                    v[i] = f(x + i * n);
+            };
+        }
+
+        /**
+         * Makes a batch objective that evaluates points of a block concurrently by OpenMP threads
+         * @param n the number of parameters
+         * @param f the thread-safe objective function (should outlive the result)
+         * @return the batch objective
+         */
+        static BatchFunction parallelBatchify(int n, const std::function<T ( const T* )> &f) {
+            return [n, &f](int m, const T* x, T* v) {
+#pragma omp parallel for schedule(dynamic) if (m > 1)
+                for (int i = 0; i < m; i++)
+                    v[i] = f(x + i * n);
+            };
+        }
+
+        /**
+         * Statistics of the last search (filled in only if PANTHER_STATS is defined)
+         * @return statistics
+         */
+        const panther::SolverStats& getStats() const {
+            return mStats;
+        }
+
+        /**
+         * Sets the cache of objective values used by the following searches (nullptr turns it off)
+         * The cache may be shared by several solvers, searches throw std::invalid_argument
+         * if its dimension doesn't match the problem.
+         * @param cache the cache
+         */
+        void setCache(const std::shared_ptr<panther::EvalCache<T>>& cache) {
+            mCache = cache;
+        }
+
+        const std::shared_ptr<panther::EvalCache<T>>& getCache() const {
+            return mCache;
+        }
+
+    protected:
+        panther::SolverStats mStats;
+        std::shared_ptr<panther::EvalCache<T>> mCache;
+        /* limits of the current search, null if there are none */
+        panther::SearchControl* mControl = nullptr;
+
+        /* sets the control for the lifetime of the scope */
+        class ControlScope {
+        public:
+
+            ControlScope(BlackBoxSolver& solver, panther::SearchControl& ctl) : mSolver(solver), mOld(solver.mControl) {
+                solver.mControl = &ctl;
+            }
+
+            ~ControlScope() {
+                mSolver.mControl = mOld;
+            }
+
+        private:
+            BlackBoxSolver& mSolver;
+            panther::SearchControl* mOld;
+        };
+
+        /**
+         * Checks the limits of the current search
+         * @return true if the search should stop
+         */
+        bool stopped() const {
+            return (mControl != nullptr) && mControl->stopped();
+        }
+
+        /**
+         * Checks that the cache (if set) keeps points of the problem dimension
+         * @param n the number of parameters
+         */
+        void checkCache(int n) const {
+            if (mCache && (mCache->dim() != n))
+                throw std::invalid_argument("cache dimension " + std::to_string(mCache->dim()) + " doesn't match the dimension " + std::to_string(n));
+        }
+
+#ifdef PANTHER_STATS
+        /**
+         * Wraps the objective to count evaluations and the time spent in it
+         * (in the control as well if it is set) and to look up values in the cache if it is set
+         * @param n the number of parameters
+         * @param f the objective (should outlive the result)
+         * @return the wrapped objective
+         */
+        BatchFunction instrument(int n, const BatchFunction &f) {
+            checkCache(n);
+            BatchFunction eval = [this, ctl = mControl, &f](int m, const T* x, T* v) {
+                PANTHER_STATS_TIMER(mStats.mFuncTime);
+                if (ctl != nullptr)
+                    ctl->addEvals(m);
+#pragma omp atomic
+                mStats.mEvals += m;
+#pragma omp atomic
+                mStats.mCalls++;
+                f(m, x, v);
+            };
+            if (!mCache)
+                return eval;
+            return [this, cache = mCache, eval](int m, const T* x, T* v) {
+                const int k = cache->evaluate(m, x, v, eval);
+#pragma omp atomic
+                mStats.mCacheHits += m - k;
+#pragma omp atomic
+                mStats.mCacheMisses += k;
+            };
+        }
+
+        std::function<T ( const T* )> instrument(int n, const std::function<T ( const T* )> &f) {
+            checkCache(n);
+            std::function<T ( const T* )> eval = [this, ctl = mControl, &f](const T* x) {
+                PANTHER_STATS_TIMER(mStats.mFuncTime);
+                if (ctl != nullptr)
+                    ctl->addEvals(1);
+#pragma omp atomic
+                mStats.mEvals++;
+#pragma omp atomic
+                mStats.mCalls++;
+                return f(x);
+            };
+            if (!mCache)
+                return eval;
+            return [this, cache = mCache, eval](const T* x) {
+                bool miss = false;
+                const T v = cache->evaluate(x, [&](const T* y) {
+                    miss = true;
+                    return eval(y);
+                });
+                if (miss) {
+#pragma omp atomic
+                    mStats.mCacheMisses++;
+                } else {
+#pragma omp atomic
+                    mStats.mCacheHits++;
+                }
+                return v;
+            };
+        }
+#else
+        /*
+         * Wraps the objective only if evaluations are looked up in the cache or counted in the control,
+         * otherwise the result refers to f. The wrapper is returned by value so that nested
+         * or concurrent searches of the same solver do not replace the one the caller uses.
+         */
+        BatchFunction instrument(int n, const BatchFunction &f) {
+            checkCache(n);
+            if (!mCache && (mControl == nullptr))
+                return std::cref(f);
+            BatchFunction eval = [ctl = mControl, &f](int m, const T* x, T* v) {
+                if (ctl != nullptr)
+                    ctl->addEvals(m);
+                f(m, x, v);
+            };
+            if (!mCache)
+                return eval;
+            return [cache = mCache, eval](int m, const T* x, T* v) {
+                cache->evaluate(m, x, v, eval);
+            };
+        }
+
+        std::function<T ( const T* )> instrument(int n, const std::function<T ( const T* )> &f) {
+            checkCache(n);
+            if (!mCache && (mControl == nullptr))
+                return std::cref(f);
+            std::function<T ( const T* )> eval = [ctl = mControl, &f](const T* x) {
+                if (ctl != nullptr)
+                    ctl->addEvals(1);
+                return f(x);
+            };
+            if (!mCache)
+                return eval;
+            return [cache = mCache, eval](const T* x) {
+                return cache->evaluate(x, eval);
+            };
+        }
+#endif
     
 };
 
 #endif /* BBSOLVER_HPP */
-
@@ -0,0 +1,119 @@
+/*
+ * File:   control.hpp
+ *
+ * Limits of a search: evaluation budget, deadline and cancellation
+ */
+
+#ifndef CONTROL_HPP
+#define CONTROL_HPP
+
+#include <atomic>
+#include <chrono>
+
+namespace panther {
+
+    /**
+     * Limits of a search checked by the solver in its main loop. When a limit is reached
+     * the solver stops and returns the best point found so far.
+     * The budget may be exceeded by one block of points per thread as blocks are not split.
+     * Counters are not reset by solvers, so one control may limit a sequence of searches.
+     * cancel() may be called by any thread while the search runs.
+     */
+    class SearchControl {
+    public:
+
+        using Clock = std::chrono::steady_clock;
+
+        /* why the search was stopped */
+        enum Reason {
+            NONE,
+            BUDGET,
+            DEADLINE,
+            CANCELLED
+        };
+
+        // Maximal number of evaluations (0 - unlimited)
+        long long mMaxEvals = 0;
+        // The search stops at this time
+        Clock::time_point mDeadline = Clock::time_point::max();
+
+        SearchControl() {
+        }
+
+        /**
+         * Limits of a search nested into another one (e.g. a local search): it also stops when the parent stops
+         * @param parent the control of the outer search (may be null)
+         */
+        explicit SearchControl(const SearchControl* parent) : mParent(parent) {
+        }
+
+        SearchControl(const SearchControl&) = delete;
+        SearchControl& operator=(const SearchControl&) = delete;
+
+        /**
+         * Sets the deadline relative to now
+         * @param seconds the time limit
+         */
+        void setTimeLimit(double seconds) {
+            mDeadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        }
+
+        /* asks the solver to stop */
+        void cancel() {
+            mCancelled.store(true, std::memory_order_relaxed);
+        }
+
+        /* counts evaluations (called by solvers) */
+        void addEvals(long long m) {
+            mEvals.fetch_add(m, std::memory_order_relaxed);
+        }
+
+        /* the number of evaluations counted so far */
+        long long evals() const {
+            return mEvals.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Checks the limits
+         * @return true if the search should stop
+         */
+        bool stopped() const {
+            if (mReason.load(std::memory_order_relaxed) != NONE)
+                return true;
+            Reason r = NONE;
+            if (mCancelled.load(std::memory_order_relaxed))
+                r = CANCELLED;
+            else if ((mMaxEvals > 0) && (evals() >= mMaxEvals))
+                r = BUDGET;
+            else if ((mDeadline != Clock::time_point::max()) && (Clock::now() >= mDeadline))
+                r = DEADLINE;
+            else if ((mParent != nullptr) && mParent->stopped())
+                r = mParent->reason();
+            if (r == NONE)
+                return false;
+            Reason none = NONE;
+            mReason.compare_exchange_strong(none, r);
+            return true;
+        }
+
+        /* the first limit that was reached, NONE if the search was not stopped */
+        Reason reason() const {
+            return mReason.load(std::memory_order_relaxed);
+        }
+
+        /* clears the counter, the cancellation and the reason, limits are kept */
+        void reset() {
+            mEvals = 0;
+            mCancelled = false;
+            mReason = NONE;
+        }
+
+    private:
+        const SearchControl* mParent = nullptr;
+        std::atomic<long long> mEvals{0};
+        std::atomic<bool> mCancelled{false};
+        mutable std::atomic<Reason> mReason{NONE};
+    };
+}
+
+#endif /* CONTROL_HPP */
@@ -0,0 +1,49 @@
+/*
+ * File:   deltaobj.hpp
+ * Author: mikhail
+ *
+ * Incremental objective interface for solvers that change one coordinate at a time
+ */
+
+#ifndef DELTAOBJ_HPP
+#define DELTAOBJ_HPP
+
+/**
+ * Objective that keeps internal state for the current point and
+ * updates its value when a single coordinate changes
+ * (e.g. separable or sparse functions where the update costs O(1) instead of O(n))
+ */
+template <class T> class DeltaObjective {
+    public:
+
+        /**
+         * Sets the current point and computes the full value at it
+         * @param n the number of parameters
+         * @param x the point
+         * @return the value at x
+         */
+        virtual T init(int n, const T* x) = 0;
+
+        /**
+         * Computes the value at the current point with one coordinate changed,
+         * the current point is not modified
+         * @param i the index of the coordinate
+         * @param xold the current value of the coordinate
+         * @param xnew the trial value of the coordinate
+         * @return the value at the trial point
+         */
+        virtual T probe(int i, T xold, T xnew) = 0;
+
+        /**
+         * Moves the current point: the i-th coordinate changes from xold to xnew
+         * @param i the index of the coordinate
+         * @param xold the current value of the coordinate
+         * @param xnew the new value of the coordinate
+         */
+        virtual void accept(int i, T xold, T xnew) = 0;
+
+        virtual ~DeltaObjective() {
+        }
+};
+
+#endif /* DELTAOBJ_HPP */
@@ -0,0 +1,278 @@
+/*
+ * File:   evalcache.hpp
+ *
+ * Bounded cache of objective values
+ */
+
+#ifndef EVALCACHE_HPP
+#define EVALCACHE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+namespace panther {
+
+    /**
+     * Cache of objective values keyed on exact coordinates of points.
+     * Keeps at most the given number of points, evicting them in the CLOCK order:
+     * a point gets a second chance if it was hit since the hand passed it last time.
+     * Points are found through an open addressing table with linear probing
+     * (twice as large as the capacity) that stores numbers of entries.
+     * All methods are thread-safe, the objective is called outside the lock.
+     * The cache knows nothing about the objective, so it should be cleared when the objective changes.
+     */
+    template <class T> class EvalCache {
+    public:
+
+        /**
+         * Constructor
+         * @param n the number of coordinates of points
+         * @param capacity the maximal number of points kept
+         */
+        EvalCache(int n, int capacity) : mDim(n), mCapacity(std::max(1, capacity)) {
+            static_assert(sizeof (T) <= sizeof (uint64_t), "the hash expects at most 64-bit coordinates");
+            size_t t = 1;
+            while (t < 2 * (size_t) mCapacity)
+                t <<= 1;
+            mTable.assign(t, EMPTY);
+            mMask = t - 1;
+            mKeys.resize((size_t) mCapacity * n);
+            mValues.resize(mCapacity);
+            mHashes.resize(mCapacity);
+            mRef.resize(mCapacity);
+        }
+
+        EvalCache(const EvalCache&) = delete;
+        EvalCache& operator=(const EvalCache&) = delete;
+
+        /**
+         * Looks up the value at a point
+         * @param x the point
+         * @param v the value (if found)
+         * @return true if the point was found
+         */
+        bool lookup(const T* x, T& v) {
+            std::lock_guard<std::mutex> lock(mLock);
+            return find(x, hash(x), v);
+        }
+
+        /**
+         * Adds the value at a point, evicting an old one if the cache is full
+         * @param x the point
+         * @param v the value
+         */
+        void insert(const T* x, T v) {
+            std::lock_guard<std::mutex> lock(mLock);
+            add(x, hash(x), v);
+        }
+
+        /**
+         * Computes the value at a point using the cache
+         * @param x the point
+         * @param f the objective: T f(const T* x)
+         * @return the value
+         */
+        template <class F> T evaluate(const T* x, F&& f) {
+            const uint64_t h = hash(x);
+            T v;
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                if (find(x, h, v))
+                    return v;
+            }
+            v = f(x);
+            std::lock_guard<std::mutex> lock(mLock);
+            add(x, h, v);
+            return v;
+        }
+
+        /**
+         * Computes values at a block of points using the cache, the objective gets only the points not found
+         * @param m the number of points
+         * @param x points stored one after another
+         * @param v the values (m values)
+         * @param f the batch objective: f(int m, const T* x, T* v)
+         * @return the number of points passed to the objective
+         */
+        template <class F> int evaluate(int m, const T* x, T* v, F&& f) {
+            std::vector<uint64_t> hs(m);
+            std::vector<int> miss;
+            for (int i = 0; i < m; i++)
+                hs[i] = hash(x + (size_t) i * mDim);
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                for (int i = 0; i < m; i++) {
+                    if (!find(x + (size_t) i * mDim, hs[i], v[i]))
+                        miss.push_back(i);
+                }
+            }
+            const int k = miss.size();
+            if (k == 0)
+                return 0;
+            if (k == m) {
+                f(m, x, v);
+            } else {
+                std::vector<T> y((size_t) k * mDim), w(k);
+                for (int q = 0; q < k; q++)
+                    std::copy(x + (size_t) miss[q] * mDim, x + (size_t) (miss[q] + 1) * mDim, y.data() + (size_t) q * mDim);
+                f(k, (const T*) y.data(), w.data());
+                for (int q = 0; q < k; q++)
+                    v[miss[q]] = w[q];
+            }
+            std::lock_guard<std::mutex> lock(mLock);
+            for (int i : miss)
+                add(x + (size_t) i * mDim, hs[i], v[i]);
+            return k;
+        }
+
+        /* removes all points and resets counters */
+        void clear() {
+            std::lock_guard<std::mutex> lock(mLock);
+            std::fill(mTable.begin(), mTable.end(), EMPTY);
+            mSize = 0;
+            mHand = 0;
+            mHits = mMisses = 0;
+        }
+
+        /* the number of points kept */
+        int size() const {
+            return mSize;
+        }
+
+        int capacity() const {
+            return mCapacity;
+        }
+
+        int dim() const {
+            return mDim;
+        }
+
+        /* the number of lookups that found the point since the creation or the last clear() */
+        long long hits() const {
+            return mHits;
+        }
+
+        /* the number of lookups that did not find the point */
+        long long misses() const {
+            return mMisses;
+        }
+
+    private:
+
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        /*
+         * Hash of coordinates' bits: every word is folded in by a rotation and a multiplication,
+         * then the result is finalized by the MurmurHash3 mixer. Adding zero turns -0 into +0
+         * as they compare equal.
+         */
+        uint64_t hash(const T* x) const {
+            uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t) mDim;
+            for (int i = 0; i < mDim; i++) {
+                const T y = x[i] + T(0);
+                uint64_t w = 0;
+                std::memcpy(&w, &y, sizeof (T));
+                h = ((h << 29) | (h >> 35)) ^ w;
+                h *= 0x9E3779B97F4A7C15ULL;
+            }
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        bool equal(uint32_t e, const T* x) const {
+            const T* k = mKeys.data() + (size_t) e * mDim;
+            for (int i = 0; i < mDim; i++) {
+                if (k[i] != x[i])
+                    return false;
+            }
+            return true;
+        }
+
+        /* the table slot of the point or of the empty cell ending its probe sequence */
+        size_t probe(const T* x, uint64_t h) const {
+            size_t s = h & mMask;
+            while (mTable[s] != EMPTY && !(mHashes[mTable[s]] == h && equal(mTable[s], x)))
+                s = (s + 1) & mMask;
+            return s;
+        }
+
+        bool find(const T* x, uint64_t h, T& v) {
+            const uint32_t e = mTable[probe(x, h)];
+            if (e == EMPTY) {
+                mMisses++;
+                return false;
+            }
+            mHits++;
+            mRef[e] = 1;
+            v = mValues[e];
+            return true;
+        }
+
+        void add(const T* x, uint64_t h, T v) {
+            size_t s = probe(x, h);
+            if (mTable[s] != EMPTY) {
+                /* added by another thread meanwhile */
+                mValues[mTable[s]] = v;
+                return;
+            }
+            uint32_t e;
+            if (mSize < mCapacity) {
+                e = mSize++;
+            } else {
+                while (mRef[mHand]) {
+                    mRef[mHand] = 0;
+                    mHand = (mHand + 1) % mCapacity;
+                }
+                e = mHand;
+                mHand = (mHand + 1) % mCapacity;
+                erase(e);
+                /* the probe sequence may have changed */
+                s = probe(x, h);
+            }
+            std::copy(x, x + mDim, mKeys.data() + (size_t) e * mDim);
+            mValues[e] = v;
+            mHashes[e] = h;
+            mRef[e] = 0;
+            mTable[s] = e;
+        }
+
+        /* removes the entry from the table shifting back the entries that follow it */
+        void erase(uint32_t e) {
+            size_t i = mHashes[e] & mMask;
+            while (mTable[i] != e)
+                i = (i + 1) & mMask;
+            for (size_t j = (i + 1) & mMask; mTable[j] != EMPTY; j = (j + 1) & mMask) {
+                const size_t home = mHashes[mTable[j]] & mMask;
+                /* the entry at j may move to i if its home is not in the cyclic range (i, j] */
+                const bool stays = (i < j) ? (home > i && home <= j) : (home > i || home <= j);
+                if (!stays) {
+                    mTable[i] = mTable[j];
+                    i = j;
+                }
+            }
+            mTable[i] = EMPTY;
+        }
+
+        int mDim;
+        int mCapacity;
+        size_t mMask;
+        int mSize = 0;
+        int mHand = 0;
+        long long mHits = 0, mMisses = 0;
+        std::vector<uint32_t> mTable;
+        std::vector<T> mKeys;
+        std::vector<T> mValues;
+        std::vector<uint64_t> mHashes;
+        std::vector<char> mRef;
+        std::mutex mLock;
+    };
+}
+
+#endif /* EVALCACHE_HPP */
@@ -0,0 +1,159 @@
+#ifndef _FIXEDVEC_HPP_
+#define _FIXEDVEC_HPP_
+/**
+ * Vector operations and storage for dimensions known at compile time
+ *
+ * N > 0 means the dimension is fixed and equal to N,
+ * N == 0 means the dimension is known only at run time.
+ *
+ * @file fixedvec.hpp
+ */
+
+#include <math.h>
+#include <array>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include "vec.hpp"
+
+namespace snowgoose {
+
+    /**
+     * Counterparts of VecUtils routines for vectors of length N.
+     * The dimension parameter is kept for compatibility and should be equal to N,
+     * loops have constant trip counts and are unrolled.
+     */
+    template <int N> class FixedVecUtils {
+    public:
+
+        template<class T> static void vecSet(int n, T x, T* y) {
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                y[i] = x;
+        }
+
+        template<class T> static T vecNormTwoSqr(int n, const T* x) {
+            T v = 0.;
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                v += SGSQR(x[i]);
+            return v;
+        }
+
+        template<class T> static T vecNormTwo(int n, const T* x) {
+            return sqrt(vecNormTwoSqr(n, x));
+        }
+
+        template<class T> static T vecScalarMult(int n, const T* x, const T* y) {
+            T v = 0;
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                v += x[i] * y[i];
+            return v;
+        }
+
+        template<class T> static T vecDist(int n, const T* x, const T* y) {
+            T v = 0.;
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                v += SGSQR(y[i] - x[i]);
+            return sqrt(v);
+        }
+
+        template <class T> static void vecCopy(int n, const T * x, T* y) {
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                y[i] = x[i];
+        }
+
+        template <class T> static void vecMult(int n, const T * x, T alpha, T* y) {
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                y[i] = alpha * x[i];
+        }
+
+        template <class T> static void vecSaxpy(int n, const T * x, const T *y, T alpha, T* z) {
+#pragma GCC unroll 16
+            for (int i = 0; i < N; i++)
+                z[i] = x[i] + y[i] * alpha;
+        }
+
+        template<class T> static std::string vecPrint(int n, const T* x, int prec = 0) {
+            return VecUtils::vecPrint(N, x, prec);
+        }
+    };
+
+    /**
+     * Vector routines for the dimension N: unrolled for N > 0, generic for N == 0
+     */
+    template <int N> using VecOps = typename std::conditional<(N > 0), FixedVecUtils<N>, VecUtils>::type;
+
+    /**
+     * Storage for S elements if S > 0 and for a run-time number of elements if S == 0
+     */
+    template <class T, int S> class VecStorage {
+    public:
+
+        void resize(int n) {
+        }
+
+        T* data() {
+            return mData.data();
+        }
+
+        const T* data() const {
+            return mData.data();
+        }
+
+        T& operator[](int i) {
+            return mData[i];
+        }
+
+        const T& operator[](int i) const {
+            return mData[i];
+        }
+
+    private:
+        std::array<T, S> mData;
+    };
+
+    template <class T> class VecStorage<T, 0> {
+    public:
+
+        void resize(int n) {
+            mData.resize(n);
+        }
+
+        T* data() {
+            return mData.data();
+        }
+
+        const T* data() const {
+            return mData.data();
+        }
+
+        T& operator[](int i) {
+            return mData[i];
+        }
+
+        const T& operator[](int i) const {
+            return mData[i];
+        }
+
+    private:
+        std::vector<T> mData;
+    };
+
+    /**
+     * Checks that the run-time dimension agrees with the compile-time one
+     * @param n run-time dimension
+     * @return the dimension to use (N if it is fixed)
+     */
+    template <int N> int checkDim(int n) {
+        if ((N > 0) && (n != N))
+            throw std::invalid_argument("dimension " + std::to_string(n) + " doesn't match the fixed dimension " + std::to_string(N));
+        return (N > 0) ? N : n;
+    }
+}
+#endif
@@ -0,0 +1,92 @@
+/*
+ * File:   lowdisc.hpp
+ * Author: mikhail
+ *
+ * Low-discrepancy sequences
+ */
+
+#ifndef LOWDISC_HPP
+#define LOWDISC_HPP
+
+#include <vector>
+
+namespace snowgoose {
+
+    /**
+     * Halton sequence in the unit cube
+     * Points are computed directly by their indices, so the sequence
+     * can be shared by threads without synchronization
+     */
+    class Halton {
+    public:
+
+        /**
+         * Constructor
+         * @param n the dimension
+         */
+        Halton(int n) : mBases(n) {
+            int p = 2;
+            for (int i = 0; i < n; i++) {
+                while (!isPrime(p))
+                    p++;
+                mBases[i] = p++;
+            }
+        }
+
+        /**
+         * Computes a point of the sequence
+         * @param k the index of the point (starting from 0)
+         * @param x the point in [0,1)^n
+         */
+        template <class T> void point(long long k, T* x) const {
+            const int n = mBases.size();
+            for (int i = 0; i < n; i++)
+                x[i] = radicalInverse(k + 1, mBases[i]);
+        }
+
+        /**
+         * Computes a point of the sequence scaled to the box
+         * @param k the index of the point (starting from 0)
+         * @param a lower bounds
+         * @param b upper bounds
+         * @param x the point in [a,b)
+         */
+        template <class T> void point(long long k, const T* a, const T* b, T* x) const {
+            const int n = mBases.size();
+            for (int i = 0; i < n; i++)
+                x[i] = a[i] + (b[i] - a[i]) * radicalInverse(k + 1, mBases[i]);
+        }
+
+        /**
+         * Van der Corput radical inverse
+         * @param k the index
+         * @param base the base
+         * @return the digits of k in the base mirrored about the point
+         */
+        static double radicalInverse(long long k, int base) {
+            const double ib = 1. / base;
+            double f = ib;
+            double r = 0;
+            while (k > 0) {
+                r += f * (k % base);
+                k /= base;
+                f *= ib;
+            }
+            return r;
+        }
+
+    private:
+
+        static bool isPrime(int p) {
+            for (int d = 2; d * d <= p; d++) {
+                if (p % d == 0)
+                    return false;
+            }
+            return true;
+        }
+
+        std::vector<int> mBases;
+    };
+}
+
+#endif /* LOWDISC_HPP */
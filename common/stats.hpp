@@ -0,0 +1,134 @@
+/* 
+ * File:   stats.hpp
+ *
+ * Solver instrumentation: evaluation counters and timers.
+ * Instrumentation is compiled in only if PANTHER_STATS is defined,
+ * otherwise the macros below expand to nothing.
+ */
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <initializer_list>
+
+namespace panther {
+
+    /**
+     * Statistics collected by a solver during the last search
+     */
+    struct SolverStats {
+        /**
+         * Number of evaluated points
+         */
+        long long mEvals = 0;
+        /**
+         * Number of calls to the objective (a batch is one call)
+         */
+        long long mCalls = 0;
+        /**
+         * Number of points found in the cache of objective values
+         */
+        long long mCacheHits = 0;
+        /**
+         * Number of points looked up in the cache and not found (they are evaluated)
+         */
+        long long mCacheMisses = 0;
+        /**
+         * Wall time of the search (seconds)
+         */
+        double mTotalTime = 0;
+        /**
+         * Time spent inside the objective (seconds, summed over threads)
+         */
+        double mFuncTime = 0;
+        /**
+         * Names of solver phases
+         */
+        std::vector<std::string> mPhaseNames;
+        /**
+         * Time spent in solver phases (seconds, summed over threads)
+         * Phases do not overlap, the time in the objective is counted in the phase that calls it.
+         */
+        std::vector<double> mPhaseTimes;
+
+        /**
+         * Clears counters and sets phases
+         * @param phases names of phases
+         */
+        void reset(std::initializer_list<const char*> phases = {}) {
+            mEvals = 0;
+            mCalls = 0;
+            mCacheHits = 0;
+            mCacheMisses = 0;
+            mTotalTime = 0;
+            mFuncTime = 0;
+            mPhaseNames.assign(phases.begin(), phases.end());
+            mPhaseTimes.assign(mPhaseNames.size(), 0.);
+        }
+
+        /**
+         * Time spent in the solver itself
+         * @return the time (seconds)
+         */
+        double overheadTime() const {
+            return mTotalTime - mFuncTime;
+        }
+
+        std::string toString() const {
+            std::ostringstream os;
+            os << "evaluations = " << mEvals << "\n";
+            os << "objective calls = " << mCalls << "\n";
+            if (mCacheHits + mCacheMisses > 0) {
+                os << "cache hits = " << mCacheHits << " of " << mCacheHits + mCacheMisses
+                        << " (" << 100. * mCacheHits / (mCacheHits + mCacheMisses) << "%)\n";
+            }
+            os << "total time = " << mTotalTime << "\n";
+            os << "time in objective = " << mFuncTime << "\n";
+            os << "solver overhead = " << overheadTime() << "\n";
+            if (!mPhaseNames.empty())
+                os << "phase times (disjoint, including calls of the objective):\n";
+            for (size_t i = 0; i < mPhaseNames.size(); i++)
+                os << "phase " << mPhaseNames[i] << " = " << mPhaseTimes[i] << "\n";
+            return os.str();
+        }
+    };
+
+    /**
+     * Adds the wall time of a scope to an accumulator
+     */
+    class ScopedTimer {
+    public:
+
+        ScopedTimer(double& acc) : mAcc(acc), mStart(std::chrono::steady_clock::now()) {
+        }
+
+        ~ScopedTimer() {
+            const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+#pragma omp atomic
+            mAcc += t;
+        }
+
+    private:
+        double& mAcc;
+        std::chrono::steady_clock::time_point mStart;
+    };
+}
+
+#define PANTHER_STATS_CAT2(a, b) a##b
+#define PANTHER_STATS_CAT(a, b) PANTHER_STATS_CAT2(a, b)
+
+#ifdef PANTHER_STATS
+/* measure the rest of the scope adding the time to acc */
+#define PANTHER_STATS_TIMER(acc) panther::ScopedTimer PANTHER_STATS_CAT(pantherTimer, __LINE__)(acc)
+/* execute the statement only if statistics are on */
+#define PANTHER_STATS_DO(stmt) stmt
+#else
+#define PANTHER_STATS_TIMER(acc)
+#define PANTHER_STATS_DO(stmt)
+#endif
+
+#endif /* STATS_HPP */
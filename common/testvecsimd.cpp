@@ -0,0 +1,94 @@
+/* 
+ * File:   testvecsimd.cpp
+ *
+ * Compares vectorized VecUtils routines with the scalar ones on every supported level
+ * and reports their speed
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "vec.hpp"
+
+using snowgoose::VecUtils;
+namespace simd = snowgoose::simd;
+
+const char* names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+/* relative error of a reduction: the order of summation differs */
+template <class T> bool close(T v, T ref, int n) {
+    return std::abs(v - ref) <= 4 * n * std::numeric_limits<T>::epsilon() * std::max(std::abs(ref), T(1));
+}
+
+/* checks all lengths up to maxn with unaligned starts, returns the number of failures */
+template <class T> int check(int maxn) {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<T> dist(-1, 1);
+    std::vector<T> x(maxn + 1), y(maxn + 1), z(maxn + 1), r(maxn + 1);
+    for (int i = 0; i <= maxn; i++) {
+        x[i] = dist(gen);
+        y[i] = dist(gen);
+    }
+    int fails = 0;
+    const T alpha = dist(gen);
+    for (int n = 0; n <= maxn; n++) {
+        for (int off = 0; off <= 1 && off + n <= maxn; off++) {
+            const T* xp = x.data() + off;
+            const T* yp = y.data() + off;
+            fails += !close(VecUtils::vecScalarMult(n, xp, yp), VecUtils::vecScalarMult<T>(n, xp, yp), n);
+            fails += !close(VecUtils::vecNormTwoSqr(n, xp), VecUtils::vecNormTwoSqr<T>(n, xp), n);
+            fails += !close(VecUtils::vecDist(n, xp, yp), VecUtils::vecDist<T>(n, xp, yp), n);
+            VecUtils::vecSaxpy(n, xp, yp, alpha, z.data());
+            VecUtils::vecSaxpy<T>(n, xp, yp, alpha, r.data());
+            fails += !std::equal(z.begin(), z.begin() + n, r.begin());
+            VecUtils::vecMult(n, xp, alpha, z.data());
+            VecUtils::vecMult<T>(n, xp, alpha, r.data());
+            fails += !std::equal(z.begin(), z.begin() + n, r.begin());
+            VecUtils::vecCopy(n, xp, z.data());
+            fails += !std::equal(z.begin(), z.begin() + n, xp);
+        }
+    }
+    return fails;
+}
+
+/* time of one call of a routine on vectors of length n (nanoseconds) */
+template <class T> double timeSaxpyDot(int n) {
+    std::vector<T> x(n, 1), y(n, 0.5), z(n);
+    const int reps = std::max(1, 20000000 / std::max(n, 1));
+    T s = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < reps; k++) {
+        VecUtils::vecSaxpy(n, x.data(), y.data(), (T) 1e-3, z.data());
+        s += VecUtils::vecScalarMult(n, z.data(), y.data());
+    }
+    const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (s == 42)
+        std::cout << "";
+    return t * 1e9 / reps;
+}
+
+int main() {
+    std::cout << "supported level: " << names[simd::supported()] << "\n";
+    int fails = 0;
+    for (int l = simd::SCALAR; l <= simd::supported(); l++) {
+        simd::setLevel(static_cast<simd::Level> (l));
+        const int fd = check<double>(300);
+        const int ff = check<float>(300);
+        std::cout << names[l] << ": " << fd << " failures for double, " << ff << " for float\n";
+        fails += fd + ff;
+    }
+    for (int n : {16, 32, 64, 100, 400}) {
+        std::cout << "saxpy + dot, n = " << n << ":";
+        for (int l = simd::SCALAR; l <= simd::supported(); l++) {
+            simd::setLevel(static_cast<simd::Level> (l));
+            std::cout << " " << names[l] << " " << timeSaxpyDot<double>(n) << " ns";
+        }
+        std::cout << "\n";
+    }
+    simd::setLevel(simd::supported());
+    std::cout << (fails ? "FAILED\n" : "OK\n");
+    return fails ? 1 : 0;
+}
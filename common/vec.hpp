@@ -13,12 +13,19 @@
  */
 
 #include <math.h>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include "utilmacro.hpp"
+#include "vecsimd.hpp"
 
 namespace snowgoose {
 
+    /**
+     * Routines are templates, vecNormTwoSqr, vecScalarMult, vecDist, vecCopy, vecMult and vecSaxpy
+     * have overloads for float and double that run vectorized kernels (see vecsimd.hpp).
+     * The templates called with an explicit type (e.g. vecSaxpy<double>) are the scalar reference.
+     */
     class VecUtils {
     public:
 
@@ -82,6 +89,18 @@ namespace snowgoose {
             return v;
         }
 
+        static double vecNormTwoSqr(int n, const double* x) {
+            if (auto k = simd::kernels<double>(n))
+                return k->mSqr(n, x);
+            return vecNormTwoSqr<double>(n, x);
+        }
+
+        static float vecNormTwoSqr(int n, const float* x) {
+            if (auto k = simd::kernels<float>(n))
+                return k->mSqr(n, x);
+            return vecNormTwoSqr<float>(n, x);
+        }
+
         /**
          * Compute "second" vector norm 
          * @param n dimension
@@ -107,6 +126,18 @@ namespace snowgoose {
             return v;
         }
 
+        static double vecScalarMult(int n, const double* x, const double* y) {
+            if (auto k = simd::kernels<double>(n))
+                return k->mDot(n, x, y);
+            return vecScalarMult<double>(n, x, y);
+        }
+
+        static float vecScalarMult(int n, const float* x, const float* y) {
+            if (auto k = simd::kernels<float>(n))
+                return k->mDot(n, x, y);
+            return vecScalarMult<float>(n, x, y);
+        }
+
         /**
          * Compute the square distance between two vectors 
          * @param n dimension
@@ -121,6 +152,18 @@ namespace snowgoose {
             return sqrt(v);
         }
 
+        static double vecDist(int n, const double* x, const double* y) {
+            if (auto k = simd::kernels<double>(n))
+                return sqrt(k->mDist2(n, x, y));
+            return vecDist<double>(n, x, y);
+        }
+
+        static float vecDist(int n, const float* x, const float* y) {
+            if (auto k = simd::kernels<float>(n))
+                return sqrt(k->mDist2(n, x, y));
+            return vecDist<float>(n, x, y);
+        }
+
         /**
          * Compute the absolute distance between two vectors
          * @param n dimension
@@ -160,6 +203,17 @@ namespace snowgoose {
                 y[i] = x[i];
         }
 
+        /* memmove is vectorized by the C library */
+        static void vecCopy(int n, const double * x, double* y) {
+            if (n > 0)
+                std::memmove(y, x, n * sizeof (double));
+        }
+
+        static void vecCopy(int n, const float * x, float* y) {
+            if (n > 0)
+                std::memmove(y, x, n * sizeof (float));
+        }
+
         /**
          * Reverts the vector
          * @param n dimension 
@@ -182,6 +236,18 @@ namespace snowgoose {
                 y[i] = alpha * x[i];
         }
 
+        static void vecMult(int n, const double * x, double alpha, double* y) {
+            if (auto k = simd::kernels<double>(n))
+                return k->mMult(n, x, alpha, y);
+            vecMult<double>(n, x, alpha, y);
+        }
+
+        static void vecMult(int n, const float * x, float alpha, float* y) {
+            if (auto k = simd::kernels<float>(n))
+                return k->mMult(n, x, alpha, y);
+            vecMult<float>(n, x, alpha, y);
+        }
+
         /**
          * Multiplies vector by a scalar and adds another vector z = x + alpha * y
          * @param n dimension
@@ -195,6 +261,18 @@ namespace snowgoose {
                 z[i] = x[i] + y[i] * alpha;
         }
 
+        static void vecSaxpy(int n, const double * x, const double *y, double alpha, double* z) {
+            if (auto k = simd::kernels<double>(n))
+                return k->mSaxpy(n, x, y, alpha, z);
+            vecSaxpy<double>(n, x, y, alpha, z);
+        }
+
+        static void vecSaxpy(int n, const float * x, const float *y, float alpha, float* z) {
+            if (auto k = simd::kernels<float>(n))
+                return k->mSaxpy(n, x, y, alpha, z);
+            vecSaxpy<float>(n, x, y, alpha, z);
+        }
+
        /**
         * Component-wise multiplication of two vectors Multiply 
         * @param n
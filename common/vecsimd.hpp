@@ -0,0 +1,377 @@
+#ifndef _VECSIMD_HPP_
+#define _VECSIMD_HPP_
+/**
+ * Vectorized kernels for VecUtils routines on float and double
+ *
+ * Kernels are written once with GCC vector types and compiled for SSE2, AVX2 and AVX-512
+ * by target attributes, the best level supported by the CPU is chosen at the first call.
+ * Every level has a minimal vector length, shorter vectors go to lower levels (see minLength).
+ * Reductions sum in a different order than the scalar loops, so results may differ in the last bits.
+ * Define SNOWGOOSE_NO_SIMD to use the scalar loops only (they are always used off x86).
+ *
+ * @file vecsimd.hpp
+ */
+
+#include <cstring>
+
+#if !defined(SNOWGOOSE_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SNOWGOOSE_SIMD
+#include <immintrin.h>
+#endif
+
+namespace snowgoose {
+
+    namespace simd {
+
+        /**
+         * Instruction sets
+         */
+        enum Level {
+            SCALAR,
+            SSE2,
+            AVX2,
+            AVX512
+        };
+
+        /**
+         * Shorter vectors are processed by scalar loops as the call through the table costs more
+         */
+        constexpr int MIN_LENGTH = 8;
+
+        /**
+         * Minimal length of vectors processed by a level, shorter ones go to the next lower level:
+         * AVX-512 loses to AVX2 on short vectors (the wider loop and reduction do not pay off)
+         * @param level the level
+         * @return the length
+         */
+        constexpr int minLength(Level level) {
+            return (level == AVX512) ? 128 : MIN_LENGTH;
+        }
+
+        /**
+         * Kernels of one level
+         */
+        template <class T> struct Kernels {
+            // sum of x[i] * y[i]
+            T(*mDot)(int n, const T* x, const T* y);
+            // sum of x[i]^2
+            T(*mSqr)(int n, const T* x);
+            // sum of (y[i] - x[i])^2
+            T(*mDist2)(int n, const T* x, const T* y);
+            // z = x + alpha * y
+            void (*mSaxpy)(int n, const T* x, const T* y, T alpha, T* z);
+            // y = alpha * x
+            void (*mMult)(int n, const T* x, T alpha, T* y);
+        };
+
+#ifdef SNOWGOOSE_SIMD
+
+        namespace detail {
+
+            /* vector of B bytes */
+            template <class T, int B> struct VecType;
+
+            template <> struct VecType<double, 16> {
+                typedef double type __attribute__ ((vector_size(16)));
+            };
+
+            template <> struct VecType<double, 32> {
+                typedef double type __attribute__ ((vector_size(32)));
+            };
+
+            template <> struct VecType<double, 64> {
+                typedef double type __attribute__ ((vector_size(64)));
+            };
+
+            template <> struct VecType<float, 16> {
+                typedef float type __attribute__ ((vector_size(16)));
+            };
+
+            template <> struct VecType<float, 32> {
+                typedef float type __attribute__ ((vector_size(32)));
+            };
+
+            template <> struct VecType<float, 64> {
+                typedef float type __attribute__ ((vector_size(64)));
+            };
+
+/* kernels are inlined into the entry points of every level and compiled for their instruction set */
+#define SNOWGOOSE_SIMD_INLINE inline __attribute__ ((always_inline))
+
+            /*
+             * Reduction: op(s, x[i], y[i]) adds a term to s for every i, terms are summed in four vector accumulators,
+             * lanes are added at the end and the tail is summed by the scalar loop
+             */
+            template <class T, int B, class Op> SNOWGOOSE_SIMD_INLINE T reduce(int n, const T* x, const T* y, Op op) {
+                typedef typename VecType<T, B>::type V;
+                constexpr int W = B / sizeof (T);
+                V s0 = {}, s1 = {}, s2 = {}, s3 = {};
+                V u0, u1, u2, u3, w0, w1, w2, w3;
+                int i = 0;
+                for (; i + 4 * W <= n; i += 4 * W) {
+                    std::memcpy(&u0, x + i, B);
+                    std::memcpy(&u1, x + i + W, B);
+                    std::memcpy(&u2, x + i + 2 * W, B);
+                    std::memcpy(&u3, x + i + 3 * W, B);
+                    std::memcpy(&w0, y + i, B);
+                    std::memcpy(&w1, y + i + W, B);
+                    std::memcpy(&w2, y + i + 2 * W, B);
+                    std::memcpy(&w3, y + i + 3 * W, B);
+                    op(s0, u0, w0);
+                    op(s1, u1, w1);
+                    op(s2, u2, w2);
+                    op(s3, u3, w3);
+                }
+                for (; i + W <= n; i += W) {
+                    std::memcpy(&u0, x + i, B);
+                    std::memcpy(&w0, y + i, B);
+                    op(s0, u0, w0);
+                }
+                s0 += s1 + s2 + s3;
+                T v = 0;
+                for (int k = 0; k < W; k++)
+                    v += s0[k];
+                for (; i < n; i++)
+                    op(v, x[i], y[i]);
+                return v;
+            }
+
+            /* u = x[i] is updated by op(u, y[i]) and stored to z[i], the tail is computed by the scalar loop */
+            template <class T, int B, class Op> SNOWGOOSE_SIMD_INLINE void map(int n, const T* x, const T* y, T* z, Op op) {
+                typedef typename VecType<T, B>::type V;
+                constexpr int W = B / sizeof (T);
+                V u0, u1, w0, w1;
+                int i = 0;
+                for (; i + 2 * W <= n; i += 2 * W) {
+                    std::memcpy(&u0, x + i, B);
+                    std::memcpy(&u1, x + i + W, B);
+                    std::memcpy(&w0, y + i, B);
+                    std::memcpy(&w1, y + i + W, B);
+                    op(u0, w0);
+                    op(u1, w1);
+                    std::memcpy(z + i, &u0, B);
+                    std::memcpy(z + i + W, &u1, B);
+                }
+                for (; i + W <= n; i += W) {
+                    std::memcpy(&u0, x + i, B);
+                    std::memcpy(&w0, y + i, B);
+                    op(u0, w0);
+                    std::memcpy(z + i, &u0, B);
+                }
+                for (; i < n; i++) {
+                    T u = x[i];
+                    op(u, y[i]);
+                    z[i] = u;
+                }
+            }
+
+            /*
+             * Operations on vectors or scalars, arguments are passed by references
+             * as the ABI of vector arguments differs between instruction sets
+             */
+
+            /* s += u * w */
+            struct Mul {
+
+                template <class V> SNOWGOOSE_SIMD_INLINE void operator()(V& s, const V& u, const V& w) const {
+                    s += u * w;
+                }
+            };
+
+            /* s += (w - u)^2 */
+            struct SqrDiff {
+
+                template <class V> SNOWGOOSE_SIMD_INLINE void operator()(V& s, const V& u, const V& w) const {
+                    s += (w - u) * (w - u);
+                }
+            };
+
+            /* u = u + w * alpha */
+            template <class T> struct Axpy {
+                T mAlpha;
+
+                template <class V> SNOWGOOSE_SIMD_INLINE void operator()(V& u, const V& w) const {
+                    u = u + w * mAlpha;
+                }
+            };
+
+            /* u = alpha * u */
+            template <class T> struct Scale {
+                T mAlpha;
+
+                template <class V> SNOWGOOSE_SIMD_INLINE void operator()(V& u, const V&) const {
+                    u = mAlpha * u;
+                }
+            };
+
+            template <class T, int B> SNOWGOOSE_SIMD_INLINE T dot(int n, const T* x, const T* y) {
+                return reduce<T, B>(n, x, y, Mul());
+            }
+
+            template <class T, int B> SNOWGOOSE_SIMD_INLINE T sqr(int n, const T* x) {
+                return reduce<T, B>(n, x, x, Mul());
+            }
+
+            template <class T, int B> SNOWGOOSE_SIMD_INLINE T dist2(int n, const T* x, const T* y) {
+                return reduce<T, B>(n, x, y, SqrDiff());
+            }
+
+            template <class T, int B> SNOWGOOSE_SIMD_INLINE void saxpy(int n, const T* x, const T* y, T alpha, T* z) {
+                map<T, B>(n, x, y, z, Axpy<T>{alpha});
+            }
+
+            template <class T, int B> SNOWGOOSE_SIMD_INLINE void mult(int n, const T* x, T alpha, T* y) {
+                map<T, B>(n, x, x, y, Scale<T>{alpha});
+            }
+
+#undef SNOWGOOSE_SIMD_INLINE
+
+/*
+ * Entry points of a level: the kernels with B-byte vectors compiled for the instruction set.
+ * LEAVE is executed before returning: AVX levels clear upper halves of registers,
+ * otherwise SSE instructions of the caller compiled without AVX are slowed down by state transitions.
+ */
+#define SNOWGOOSE_SIMD_LEVEL(NAME, TARGET, B, LEAVE) \
+            struct NAME { \
+                template <class T> __attribute__ ((target(TARGET))) static T dot(int n, const T* x, const T* y) { \
+                    const T v = detail::dot<T, B>(n, x, y); \
+                    LEAVE; \
+                    return v; \
+                } \
+                template <class T> __attribute__ ((target(TARGET))) static T sqr(int n, const T* x) { \
+                    const T v = detail::sqr<T, B>(n, x); \
+                    LEAVE; \
+                    return v; \
+                } \
+                template <class T> __attribute__ ((target(TARGET))) static T dist2(int n, const T* x, const T* y) { \
+                    const T v = detail::dist2<T, B>(n, x, y); \
+                    LEAVE; \
+                    return v; \
+                } \
+                template <class T> __attribute__ ((target(TARGET))) static void saxpy(int n, const T* x, const T* y, T alpha, T* z) { \
+                    detail::saxpy<T, B>(n, x, y, alpha, z); \
+                    LEAVE; \
+                } \
+                template <class T> __attribute__ ((target(TARGET))) static void mult(int n, const T* x, T alpha, T* y) { \
+                    detail::mult<T, B>(n, x, alpha, y); \
+                    LEAVE; \
+                } \
+                template <class T> static Kernels<T> kernels() { \
+                    return {&dot<T>, &sqr<T>, &dist2<T>, &saxpy<T>, &mult<T>}; \
+                } \
+            };
+
+            SNOWGOOSE_SIMD_LEVEL(Sse2, "sse2", 16, (void) 0)
+            SNOWGOOSE_SIMD_LEVEL(Avx2, "avx2", 32, _mm256_zeroupper())
+            SNOWGOOSE_SIMD_LEVEL(Avx512, "avx512f", 64, _mm256_zeroupper())
+
+#undef SNOWGOOSE_SIMD_LEVEL
+
+            /* the best level supported by the CPU */
+            inline Level detect() {
+                static const Level level = [] {
+                    __builtin_cpu_init();
+                    if (__builtin_cpu_supports("avx512f"))
+                        return AVX512;
+                    if (__builtin_cpu_supports("avx2"))
+                        return AVX2;
+                    if (__builtin_cpu_supports("sse2"))
+                        return SSE2;
+                    return SCALAR;
+                }();
+                return level;
+            }
+
+            /* the level in use */
+            inline Level& current() {
+                static Level level = detect();
+                return level;
+            }
+
+            template <class T> Kernels<T> make(Level level) {
+                switch (level) {
+                    case AVX512:
+                        return Avx512::kernels<T>();
+                    case AVX2:
+                        return Avx2::kernels<T>();
+                    case SSE2:
+                        return Sse2::kernels<T>();
+                    default:
+                        return {};
+                }
+            }
+
+            /* kernels of all levels indexed by the level (null pointers for unsupported ones) */
+            template <class T> const Kernels<T>* tables() {
+                static const struct Tables {
+                    Kernels<T> mLevels[AVX512 + 1];
+
+                    Tables() {
+                        for (int l = SCALAR; l <= AVX512; l++)
+                            mLevels[l] = (l <= detect()) ? make<T>(static_cast<Level> (l)) : Kernels<T>{};
+                    }
+                } t;
+                return t.mLevels;
+            }
+        }
+
+        /**
+         * The level in use
+         * @return the level
+         */
+        inline Level level() {
+            return detail::current();
+        }
+
+        /**
+         * The best level supported by the CPU
+         * @return the level
+         */
+        inline Level supported() {
+            return detail::detect();
+        }
+
+        /**
+         * Switches to another level (e.g. to compare them), not while other threads use vector routines
+         * @param level the level (lowered to the supported one)
+         * @return the level in use
+         */
+        inline Level setLevel(Level level) {
+            const Level l = (level > supported()) ? supported() : level;
+            detail::current() = l;
+            return l;
+        }
+
+        /**
+         * Kernels for vectors of length n: the highest level up to the one in use that takes such vectors
+         * @param n the length
+         * @return kernels or null if scalar loops should be used
+         */
+        template <class T> const Kernels<T>* kernels(int n) {
+            int l = detail::current();
+            while ((l > SCALAR) && (n < minLength(static_cast<Level> (l))))
+                l--;
+            return (l > SCALAR) ? detail::tables<T>() + l : nullptr;
+        }
+#else
+
+        inline Level level() {
+            return SCALAR;
+        }
+
+        inline Level supported() {
+            return SCALAR;
+        }
+
+        inline Level setLevel(Level) {
+            return SCALAR;
+        }
+
+        template <class T> const Kernels<T>* kernels(int) {
+            return nullptr;
+        }
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,188 @@
+/* 
+ * File:   boxarena.hpp
+ * Author: posypkin
+ *
+ * Contiguous storage for hyperintervals
+ */
+
+#ifndef BOXARENA_HPP
+#define BOXARENA_HPP
+
+#include <vector>
+#include <algorithm>
+
+namespace panther {
+
+    /**
+     * A pool of hyperintervals stored as a structure of arrays.
+     * Bounds of the i-th box occupy 2 * n consecutive elements (first a then b),
+     * local upper and lower bounds are kept in separate arrays so scans over them
+     * don't touch coordinates. Clearing keeps the memory, so the pool makes no
+     * allocations once it has grown to the size of the widest frontier.
+     * Released boxes are reused by subsequent additions.
+     * Optionally every box carries a fixed number of values (e.g. cached function values).
+     */
+    template <class T> class BoxArena {
+    public:
+
+        /**
+         * Prepares an empty pool
+         * @param n the number of dimensions
+         * @param m the number of values per box
+         */
+        void init(int n, int m = 0) {
+            if ((n != mDim) || (m != mVals)) {
+                /* the layout changes so the memory can't be reused */
+                mBounds.clear();
+                mValues.clear();
+                mLocLO.clear();
+                mLocUB.clear();
+            }
+            mDim = n;
+            mVals = m;
+            clear();
+        }
+
+        /**
+         * Reserves space for boxes
+         * @param cap the number of boxes
+         */
+        void reserve(int cap) {
+            if (cap > capacity()) {
+                mBounds.resize(2 * mDim * cap);
+                mValues.resize(mVals * cap);
+                mLocLO.resize(cap);
+                mLocUB.resize(cap);
+            }
+        }
+
+        /**
+         * Adds a box with unset bounds
+         * @return the number of the new box
+         */
+        int add() {
+            if (!mFree.empty()) {
+                const int i = mFree.back();
+                mFree.pop_back();
+                return i;
+            }
+            if (mSize == capacity())
+                reserve(std::max(16, 2 * mSize));
+            return mSize++;
+        }
+
+        /**
+         * Adds a box
+         * @param a lower bounds
+         * @param b upper bounds
+         * @return the number of the new box
+         */
+        int add(const T* a, const T* b) {
+            const int i = add();
+            std::copy(a, a + mDim, this->a(i));
+            std::copy(b, b + mDim, this->b(i));
+            return i;
+        }
+
+        /**
+         * Returns a box to the pool
+         * @param i the number of the box
+         */
+        void release(int i) {
+            mFree.push_back(i);
+        }
+
+        /**
+         * Removes all boxes keeping the memory
+         */
+        void clear() {
+            mSize = 0;
+            mFree.clear();
+        }
+
+        /**
+         * Exchanges contents with another pool
+         * @param other the pool to exchange with
+         */
+        void swap(BoxArena& other) {
+            std::swap(mDim, other.mDim);
+            std::swap(mVals, other.mVals);
+            std::swap(mSize, other.mSize);
+            mValues.swap(other.mValues);
+            mBounds.swap(other.mBounds);
+            mLocLO.swap(other.mLocLO);
+            mLocUB.swap(other.mLocUB);
+            mFree.swap(other.mFree);
+        }
+
+        /* the number of boxes ever added and not cleared (including released ones) */
+        int size() const {
+            return mSize;
+        }
+
+        /* the number of boxes in use */
+        int live() const {
+            return mSize - mFree.size();
+        }
+
+        bool empty() const {
+            return live() == 0;
+        }
+
+        int capacity() const {
+            return mLocLO.size();
+        }
+
+        /* the number of dimensions */
+        int dim() const {
+            return mDim;
+        }
+
+        /* the number of values per box */
+        int nvals() const {
+            return mVals;
+        }
+
+        /* lower bounds of the i-th box */
+        T* a(int i) {
+            return mBounds.data() + 2 * mDim * i;
+        }
+
+        const T* a(int i) const {
+            return mBounds.data() + 2 * mDim * i;
+        }
+
+        /* upper bounds of the i-th box */
+        T* b(int i) {
+            return mBounds.data() + 2 * mDim * i + mDim;
+        }
+
+        const T* b(int i) const {
+            return mBounds.data() + 2 * mDim * i + mDim;
+        }
+
+        /* values attached to the i-th box */
+        T* vals(int i) {
+            return mValues.data() + mVals * i;
+        }
+
+        /* local lower bound of the function on the i-th box */
+        T& lo(int i) {
+            return mLocLO[i];
+        }
+
+        /* local upper bound of the function on the i-th box */
+        T& ub(int i) {
+            return mLocUB[i];
+        }
+
+    private:
+        int mDim = 0, mVals = 0, mSize = 0;
+        std::vector<T> mBounds;
+        std::vector<T> mValues;
+        std::vector<T> mLocLO, mLocUB;
+        std::vector<int> mFree;
+    };
+}
+
+#endif /* BOXARENA_HPP */
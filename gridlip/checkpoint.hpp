@@ -0,0 +1,210 @@
+/*
+ * File:   checkpoint.hpp
+ * Author: posypkin
+ *
+ * Checkpoint files of the GridLip frontier
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "boxarena.hpp"
+#include "spillfile.hpp"
+
+namespace panther {
+
+    /**
+     * Binary checkpoint of a set of boxes with the record.
+     * The file is a header followed by arrays aligned to 64 bytes at the offsets given in the header:
+     * the record point (dim), bounds of boxes (2 * dim per box, a then b), local lower bounds,
+     * local upper bounds and optionally values attached to boxes, so it can be used through mmap.
+     * A new checkpoint is written to a temporary file that replaces the old one by rename,
+     * so the file is always complete if the process is killed. The temporary file is synced to disk
+     * before the rename, so the checkpoint survives a crash of the system as well.
+     */
+    template <class T> class Checkpoint {
+    public:
+
+        struct Header {
+            char mMagic[8];
+            int32_t mVersion;
+            /* sizeof(T) */
+            int32_t mTypeSize;
+            int32_t mDim;
+            /* grid nodes per dimension */
+            int32_t mNodes;
+            /* values per box */
+            int32_t mVals;
+            /* 1 if local bounds of boxes are computed */
+            int32_t mEvaluated;
+            int64_t mBoxes;
+            /* the record value */
+            double mRecord;
+            int64_t mPointOff;
+            int64_t mBoundsOff;
+            int64_t mLoOff;
+            int64_t mUbOff;
+            int64_t mValsOff;
+        };
+
+        /**
+         * Writes a checkpoint
+         * @param path the file name
+         * @param nodes grid nodes per dimension
+         * @param evaluated true if local bounds of boxes are computed
+         * @param record the record value
+         * @param point the record point
+         * @param boxes the pool of boxes
+         * @param ids the numbers of boxes to write, all boxes of the pool if null
+         * @param spill boxes spilled to disk to write after the ones of the pool
+         */
+        static void save(const std::string& path, int nodes, bool evaluated, T record, const T* point,
+                BoxArena<T>& boxes, const std::vector<int>* ids = nullptr, SpillFile<T>* spill = nullptr) {
+            const int dim = boxes.dim();
+            const int nvals = boxes.nvals();
+            const int64_t nm = ids ? ids->size() : boxes.size();
+            const int64_t nb = nm + (spill ? spill->size() : 0);
+            Header h;
+            std::memset(&h, 0, sizeof (h));
+            std::memcpy(h.mMagic, MAGIC, sizeof (h.mMagic));
+            h.mVersion = VERSION;
+            h.mTypeSize = sizeof (T);
+            h.mDim = dim;
+            h.mNodes = nodes;
+            h.mVals = nvals;
+            h.mEvaluated = evaluated;
+            h.mBoxes = nb;
+            h.mRecord = record;
+            h.mPointOff = align(sizeof (Header));
+            h.mBoundsOff = align(h.mPointOff + dim * sizeof (T));
+            h.mLoOff = align(h.mBoundsOff + nb * 2 * dim * sizeof (T));
+            h.mUbOff = align(h.mLoOff + nb * sizeof (T));
+            h.mValsOff = align(h.mUbOff + nb * sizeof (T));
+
+            const std::string tmp = path + ".tmp";
+            FILE* f = fopen(tmp.c_str(), "wb");
+            if (f == nullptr)
+                throw std::runtime_error("can't open " + tmp + ": " + strerror(errno));
+            int64_t pos = 0;
+            auto put = [&](const void* p, size_t size) {
+                if (fwrite(p, 1, size, f) != size) {
+                    fclose(f);
+                    throw std::runtime_error("can't write " + tmp + ": " + strerror(errno));
+                }
+                pos += size;
+            };
+            auto pad = [&](int64_t off) {
+                static const char zeros[64] = {};
+                put(zeros, off - pos);
+            };
+            /*
+             * writes a column of the table of boxes given the accessor of the i-th row, its length
+             * and its position in a spilled record
+             */
+            auto column = [&](int64_t off, size_t len, auto row, int recpos) {
+                pad(off);
+                if (ids == nullptr) {
+                    if (nm > 0)
+                        put(row(0), nm * len * sizeof (T));
+                } else {
+                    for (int i : *ids)
+                        put(row(i), len * sizeof (T));
+                }
+                if (spill != nullptr) {
+                    spill->scan([&](const T * rec) {
+                        put(rec + recpos, len * sizeof (T));
+                    });
+                }
+            };
+            put(&h, sizeof (h));
+            pad(h.mPointOff);
+            put(point, dim * sizeof (T));
+            column(h.mBoundsOff, 2 * dim, [&](int i) {
+                return boxes.a(i);
+            }, 0);
+            column(h.mLoOff, 1, [&](int i) {
+                return &boxes.lo(i);
+            }, 2 * dim);
+            column(h.mUbOff, 1, [&](int i) {
+                return &boxes.ub(i);
+            }, 2 * dim + 1);
+            column(h.mValsOff, nvals, [&](int i) {
+                return boxes.vals(i);
+            }, 2 * dim + 2);
+            /* the data should reach the disk before the rename, otherwise after a crash the name may refer to an empty file */
+            if ((fflush(f) != 0) || (fsync(fileno(f)) != 0)) {
+                fclose(f);
+                throw std::runtime_error("can't write " + tmp + ": " + strerror(errno));
+            }
+            if (fclose(f) != 0)
+                throw std::runtime_error("can't write " + tmp + ": " + strerror(errno));
+            if (rename(tmp.c_str(), path.c_str()) != 0)
+                throw std::runtime_error("can't rename " + tmp + ": " + strerror(errno));
+        }
+
+        /**
+         * Reads a checkpoint
+         * @param path the file name
+         * @param h the header
+         * @param point the record point
+         * @param boxes the pool the boxes are added to (initialized here)
+         */
+        static void load(const std::string& path, Header& h, std::vector<T>& point, BoxArena<T>& boxes) {
+            const int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("can't open " + path + ": " + strerror(errno));
+            struct stat st;
+            void* p = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof (Header))
+                p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED)
+                throw std::runtime_error("can't map " + path);
+            const char* mem = static_cast<const char*> (p);
+            std::memcpy(&h, mem, sizeof (h));
+            const bool valid = (std::memcmp(h.mMagic, MAGIC, sizeof (h.mMagic)) == 0) && (h.mVersion == VERSION)
+                    && (h.mTypeSize == sizeof (T)) && (h.mValsOff + h.mBoxes * h.mVals * (int64_t) sizeof (T) <= st.st_size);
+            if (!valid) {
+                munmap(p, st.st_size);
+                throw std::runtime_error(path + " is not a valid checkpoint");
+            }
+            const int dim = h.mDim;
+            const T* pt = reinterpret_cast<const T*> (mem + h.mPointOff);
+            point.assign(pt, pt + dim);
+            const T* bounds = reinterpret_cast<const T*> (mem + h.mBoundsOff);
+            const T* lo = reinterpret_cast<const T*> (mem + h.mLoOff);
+            const T* ub = reinterpret_cast<const T*> (mem + h.mUbOff);
+            const T* vals = reinterpret_cast<const T*> (mem + h.mValsOff);
+            boxes.init(dim, h.mVals);
+            boxes.reserve(h.mBoxes);
+            for (int64_t k = 0; k < h.mBoxes; k++) {
+                const int i = boxes.add(bounds + 2 * dim * k, bounds + 2 * dim * k + dim);
+                boxes.lo(i) = lo[k];
+                boxes.ub(i) = ub[k];
+                std::copy(vals + h.mVals * k, vals + h.mVals * (k + 1), boxes.vals(i));
+            }
+            munmap(p, st.st_size);
+        }
+
+    private:
+        static constexpr const char* MAGIC = "PNTHRCP";
+        static constexpr int VERSION = 1;
+
+        static int64_t align(int64_t off) {
+            return (off + 63) / 64 * 64;
+        }
+    };
+}
+
+#endif /* CHECKPOINT_HPP */
@@ -15,9 +15,30 @@
 #define GRIDLIP_HPP
 
 #include <math.h>
+#include <cmath>
 #include <algorithm>
 #include <limits>
+#include <vector>
+#include <iostream>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
 #include <common/bbsolver.hpp>
+#include <common/fixedvec.hpp>
+#include "boxarena.hpp"
+#include "sharedpool.hpp"
+#include "checkpoint.hpp"
+#include "spillfile.hpp"
+#include <numeric>
+#include <chrono>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /**
  * Simple grid-based Lipschitzian solver developed by 
@@ -79,15 +100,59 @@ namespace panther {
 
     /**
      * A simple black-box optimizer that uses Lipschitzian bounds
+     * @param N the number of variables if it is known at compile time, 0 otherwise
      */
-    template <class T> class GridLip : public BlackBoxSolver <T> {
+    template <class T, int N = 0> class GridLip : public BlackBoxSolver <T> {
     public:
 
+        using BatchFunction = typename BlackBoxSolver<T>::BatchFunction;
+
+        /* The order of processing boxes */
+        enum Engine {
+            /* level by level (breadth-first) */
+            BFS,
+            /* the box with the least lower bound first */
+            BEST_FIRST,
+            /* depth-first by OpenMP threads with work stealing (one thread if mParallel is off) */
+            TASKS,
+            /* depth-first by worker processes exchanging boxes through shared memory,
+               not to be started inside an OpenMP parallel region, the objective should not use OpenMP */
+            PROCESSES
+        };
+
         struct Options {
             // Accuracy
             T mEps = 1e-1;
             // Number of node per dimension
             int mNodes = 4;
+            // Number of grid nodes passed to the objective at once
+            int mBatchSize = 256;
+            // Evaluate boxes of a level (or run TASKS workers) by several OpenMP threads (the objective should be thread-safe)
+            bool mParallel = false;
+            // The order of processing boxes
+            Engine mEngine = BFS;
+            // Maximal number of boxes kept by the BEST_FIRST engine (0 - unlimited),
+            // the boxes with the largest lower bounds are dropped when exceeded
+            // so the accuracy is not guaranteed anymore
+            int mMaxBoxes = 0;
+            // Keep grid values with boxes and pass them to the halves after bisection,
+            // so only new nodes are evaluated (requires memory for nodes^dim values per box)
+            bool mNested = false;
+            // Number of worker processes of the PROCESSES engine (0 - the number of online processors)
+            int mProcesses = 0;
+            // Capacity of the box stack shared by worker processes,
+            // when it is full workers keep new boxes to themselves
+            int mSharedBoxes = 4096;
+            // Checkpoint file (no checkpoints if empty), the frontier and the record are saved
+            // between levels by BFS and between boxes by BEST_FIRST, other engines don't write checkpoints
+            std::string mCheckpointFile;
+            // Minimal time between checkpoints (seconds). BFS checks it only between levels,
+            // so a level that takes longer than the interval is not interrupted by a checkpoint
+            double mCheckpointInterval = 5;
+            // Memory for boxes of BFS and BEST_FIRST engines (bytes, 0 - unlimited), boxes with
+            // the largest lower bounds above this limit are moved to a temporary file and read back
+            // when the boxes in memory are exhausted
+            size_t mMemoryLimit = 0;
         } mOptions;
 
         /**
@@ -96,11 +161,8 @@ namespace panther {
         GridLip() {
         }
 
-        ~GridLip() {
-            if (step != nullptr) delete[]step;
-            if (x != nullptr) delete[]x;
-            if (Fvalues != nullptr) delete[]Fvalues;
-        }
+        using BlackBoxSolver<T>::search;
+        using BlackBoxSolver<T>::searchBatch;
 
         /**
          * Search with grid solver
@@ -110,94 +172,216 @@ namespace panther {
          * @param f pointer to function for which search minimum
          */
         virtual T search(int n, T* xfound, const T * const a, const T * const b, const std::function<T(const T * const)> &f) {
-            /* reset variables */
-            dim = n;
-            nodes = mOptions.mNodes;
-            eps = mOptions.mEps;
-            allnodes = static_cast<int> (pow(nodes, dim));
-            /* create 2 vectors */
-            /* P contains parts (hyperintervals on which search must be performed */
-            /* P1 temporary */
-            try {
-                /* step of grid in every dimension */
-                if (step != nullptr) delete[]step;
-                if (x != nullptr) delete[]x;
-                if (Fvalues != nullptr) delete[]Fvalues;
-                step = new T[dim];
-                x = new T[dim];
-                Fvalues = new T[allnodes];
-            } catch (std::bad_alloc& ba) {
-                std::cerr << ba.what() << std::endl;
-                return UPB;
-            }
-            std::vector<Box <T> > P, P1;
-            /* Upper bound */
-            UPB = std::numeric_limits<T>::max();
+            return searchBatch(n, xfound, a, b, BlackBoxSolver<T>::batchify(n, f));
+        }
 
+        /**
+         * Search with grid solver, grid nodes are passed to the objective by blocks
+         * @param n number of task dimensions
+         * @param x coordinates of founded minimum (retvalue)
+         * @param a,b left/right bounds of search region
+         * @param f batch function for which search minimum
+         */
+        virtual T searchBatch(int n, T* xfound, const T * const a, const T * const b, const BatchFunction &func) {
+            PANTHER_STATS_DO(this->mStats.reset({"evaluation", "lipschitz", "subdivision"}));
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            const BatchFunction f = this->instrument(n, func);
+            if (!prepare(n))
+                return UPB;
             /* Add first hyperinterval */
 
             try {
-                P.emplace_back(dim, a, b);
+                P.add(a, b);
             } catch (std::exception& e) {
                 std::cerr << e.what() << std::endl;
                 return UPB;
             }
+            /* nothing is known about the first hyperinterval */
+            std::fill(P.vals(0), P.vals(0) + P.nvals(), std::numeric_limits<T>::quiet_NaN());
+            return run(xfound, f, false);
+        }
+
+        /**
+         * Continues the search saved to a checkpoint file
+         * @param n number of task dimensions
+         * @param x coordinates of founded minimum (retvalue)
+         * @param file the checkpoint file
+         * @param f pointer to function for which search minimum
+         */
+        T resume(int n, T* xfound, const std::string& file, const std::function<T(const T * const)> &f) {
+            return resumeBatch(n, xfound, file, BlackBoxSolver<T>::batchify(n, f));
+        }
+
+        /**
+         * Continues the search saved to a checkpoint file, grid nodes are passed to the objective by blocks
+         * The accuracy and the engine may differ from the ones of the interrupted search.
+         * @param n number of task dimensions
+         * @param x coordinates of founded minimum (retvalue)
+         * @param file the checkpoint file
+         * @param f batch function for which search minimum
+         */
+        T resumeBatch(int n, T* xfound, const std::string& file, const BatchFunction &func) {
+            PANTHER_STATS_DO(this->mStats.reset({"evaluation", "lipschitz", "subdivision"}));
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            const BatchFunction f = this->instrument(n, func);
+            typename Checkpoint<T>::Header h;
+            std::vector<T> point;
+            BoxArena<T> boxes;
+            Checkpoint<T>::load(file, h, point, boxes);
+            if (h.mDim != n)
+                throw std::invalid_argument("checkpoint " + file + " is for dimension " + std::to_string(h.mDim));
+            if (!prepare(n))
+                return UPB;
+            /* grid values are reused only if the grid is the same */
+            const bool sameGrid = (h.mNodes == nodes) && (boxes.nvals() == P.nvals());
+            for (int i = 0; i < boxes.size(); i++) {
+                const int j = P.add(boxes.a(i), boxes.b(i));
+                P.lo(j) = boxes.lo(i);
+                P.ub(j) = boxes.ub(i);
+                if (sameGrid)
+                    std::copy(boxes.vals(i), boxes.vals(i) + P.nvals(), P.vals(j));
+                else
+                    std::fill(P.vals(j), P.vals(j) + P.nvals(), std::numeric_limits<T>::quiet_NaN());
+            }
+            UPB = h.mRecord;
+            std::copy(point.begin(), point.end(), xfound);
+            const long long limit = frontierLimit();
+            if ((limit > 0) && (P.size() > limit / 3))
+                spillExcess(limit / 3);
+            return run(xfound, f, h.mEvaluated && (h.mNodes == nodes));
+        }
 
-            /* If hyperinterval divides, 2 new hyperintervals with bounds [a..b1] [a1..b] creates */
-            /* xs temporary array for storage local min coordinates */
-            T *a1, *b1, *xs;
+
+    private:
+
+        /* Set up the search for the dimension n, returns false if there is not enough memory */
+        bool prepare(int n) {
+            /* reset variables */
+            dim = snowgoose::checkDim<N>(n);
+            nodes = mOptions.mNodes;
+            eps = mOptions.mEps;
+            /* distances between neighbour nodes along coordinates dim - 1, dim - 2, ... in the grid order */
+            powers.resize(dim);
+            allnodes = 1;
+            for (int k = 0; k < dim; k++) {
+                powers[k] = allnodes;
+                allnodes *= nodes;
+            }
+            window = allnodes / nodes;
+            batch = static_cast<int> (std::max(1LL, std::min((long long) mOptions.mBatchSize, allnodes)));
             try {
-                a1 = new T[dim];
-                b1 = new T[dim];
-                xs = new T[dim];
+                /* each thread gets its own buffers */
+                scratch.resize(mOptions.mParallel ? maxThreads() : 1);
+                for (auto& s : scratch) {
+                    s.mStep.resize(dim);
+                    s.mRing.resize(window);
+                    s.mDigits.resize(dim);
+                    s.mPts.resize(batch * dim);
+                    s.mXs.resize(dim);
+                    s.mXr.resize(dim);
+                    s.mIdx.resize(batch);
+                    s.mVb.resize(batch);
+                }
             } catch (std::bad_alloc& ba) {
                 std::cerr << ba.what() << std::endl;
-                return UPB;
+                return false;
             }
+            const int nvals = mOptions.mNested ? static_cast<int> (allnodes) : 0;
+            P.init(dim, nvals);
+            P1.init(dim, nvals);
+            spill.init(dim, nvals);
+            /* Upper bound */
+            UPB = std::numeric_limits<T>::max();
+            lastCheckpoint = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        /*
+         * Run the chosen engine on the boxes of P
+         * @param evaluated local bounds of boxes in P are already computed
+         */
+        T run(T* xfound, const BatchFunction &f, bool evaluated) {
+            if (mOptions.mEngine == BEST_FIRST)
+                return searchBestFirst(xfound, f, evaluated);
+            if (mOptions.mEngine == TASKS)
+                return searchTasks(xfound, f);
+            if (mOptions.mEngine == PROCESSES)
+                return searchProcesses(xfound, f);
+
+            /* in-memory boxes of a level are limited to one third of the limit as the next level takes up to twice as many */
+            const long long limit = frontierLimit() / 3;
+            std::vector<int> loaded;
 
             /* Each hyperinterval can be subdivided or pruned (if non-promisable or fits accuracy) */
-            while (!P.empty()) {
+            while (!P.empty() || !spill.empty()) {
+                if (P.empty()) {
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                    loadSpilled(limit, loaded);
+                    continue;
+                }
+                /* all boxes of the level are waiting for evaluation */
+                if (checkpointDue())
+                    saveCheckpoint(xfound, false, nullptr);
+
                 /* number of iterations on this step (BFS) */
-                unsigned int parts = P.size();
+                int parts = P.size();
+
+                /* the best upper bound on this step, the box and the thread that found it */
+                T stepUPB = std::numeric_limits<T>::max();
+                int stepI = -1, stepT = 0;
 
                 /* For all hyperintervals on this step perform grid search */
-                for (unsigned int i = 0; i < parts; i++) {
-                    /* local values of upper and lower bounds, value of delta*L (Lipshitz const) */
-                    T lUPB, lLOB, ldeltaL;
-                    T* ta = P[i].mA, *tb = P[i].mB;
-                    gridEvaluator(ta, tb, xs, &lUPB, &lLOB, &ldeltaL, f);
-                    P[i].mLocLO = lLOB;
-                    P[i].mLocUB = lUPB;
-                    /* remember new results if less then previous */
-                    updateRecords(lUPB, xfound, xs);
+#pragma omp parallel if (mOptions.mParallel)
+                {
+                    Scratch& s = scratch[threadNum()];
+                    /* the best upper bound found by this thread and its box */
+                    T thrUPB = std::numeric_limits<T>::max();
+                    int thrI = -1;
+#pragma omp for schedule(dynamic)
+                    for (int i = 0; i < parts; i++) {
+                        if (this->stopped())
+                            continue;
+                        /* local values of upper and lower bounds, value of delta*L (Lipshitz const) */
+                        T lUPB, lLOB, ldeltaL;
+                        gridEvaluator(P.a(i), P.b(i), s.mXs.data(), &lUPB, &lLOB, &ldeltaL, f, s, nestedVals(P, i));
+                        P.lo(i) = lLOB;
+                        P.ub(i) = lUPB;
+                        if (lUPB < thrUPB) {
+                            thrUPB = lUPB;
+                            thrI = i;
+                            std::copy(s.mXs.data(), s.mXs.data() + dim, s.mXr.data());
+                        }
+                    }
+                    /* ties are resolved in favor of the first box as in the serial loop */
+#pragma omp critical
+                    {
+                        if ((thrI >= 0) && ((stepI < 0) || (thrUPB < stepUPB) || ((thrUPB == stepUPB) && (thrI < stepI)))) {
+                            stepUPB = thrUPB;
+                            stepI = thrI;
+                            stepT = threadNum();
+                        }
+                    }
                 }
+                /* remember new results if less then previous */
+                if (stepI >= 0)
+                    updateRecords(stepUPB, xfound, scratch[stepT].mXr.data());
+                /* the level is kept unevaluated, so it is in the final checkpoint */
+                if (this->stopped())
+                    break;
 
                 /* Choose which hyperintervals should be subdivided */
-                for (unsigned int i = 0; i < parts; i++) {
+                PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                for (int i = 0; i < parts; i++) {
                     /* Subdivision criteria */
-                    if (P[i].mLocLO < (UPB - eps)) {
-                        /* If subdivide, choose dimension (the longest side) */
-                        int choosen = chooseDim(P[i].mA, P[i].mB);
-
-                        /* Make new edges for 2 new hyperintervals */
-                        for (int j = 0; j < dim; j++) {
-                            if (j != choosen) { /* [a .. b1] [a1 .. b] */
-                                a1[j] = P[i].mA[j]; /* where a1 = [a[1], a[2], .. ,a[choosen] + b[choosen]/2, .. , a[dim] ] */
-                                b1[j] = P[i].mB[j]; /* and b1 = [b[1], b[2], .. ,a[choosen] + b[choosen]/2, .. , b[dim] ] */
-                            } else {
-                                a1[j] = P[i].mA[j] + fabs(P[i].mB[j] - P[i].mA[j]) / 2.0;
-                                b1[j] = a1[j];
-                            }
-                        }
+                    if (P.lo(i) < (UPB - eps)) {
                         /* Add 2 new hyperintervals, parent HI no longer considered */
+                        int l, r;
                         try {
-                            P1.emplace_back(dim, P[i].mA, b1);
-                        } catch (std::exception& e) {
-                            std::cerr << e.what() << std::endl;
-                            return UPB;
-                        }
-                        try {
-                            P1.emplace_back(dim, a1, P[i].mB);
+                            subdivide(P, i, P1, &l, &r);
+                            /* the bound of the parent orders the halves if they are spilled */
+                            P1.lo(l) = P1.lo(r) = P.lo(i);
+                            if (mOptions.mNested)
+                                inheritValues(P, i, P1, l, r, f, scratch[0]);
                         } catch (std::exception& e) {
                             std::cerr << e.what() << std::endl;
                             return UPB;
@@ -207,21 +391,694 @@ namespace panther {
 
                 P.clear();
                 P.swap(P1);
+                if ((limit > 0) && (P.size() > limit))
+                    spillExcess(limit);
             }
-            delete[]a1;
-            delete[]b1;
-            delete[]xs;
-            P.clear();
+            if (!mOptions.mCheckpointFile.empty())
+                saveCheckpoint(xfound, false, nullptr);
             return UPB;
         }
 
 
     private:
 
+        /* phases of the search in statistics */
+        enum {
+            PHASE_EVALUATION,
+            PHASE_LIPSCHITZ,
+            PHASE_SUBDIVISION
+        };
+
         T eps; /* required accuracy */
-        int nodes, dim, allnodes; /* internal varibale for handlig errors and number of nodes per dimension */
+        int nodes, dim; /* internal varibale for handlig errors and number of nodes per dimension */
+        long long allnodes; /* number of nodes in the grid */
+        long long window; /* number of nodes in one layer of the grid */
+        std::vector<long long> powers; /* powers of the number of nodes */
+        int batch; /* number of grid nodes evaluated at once */
         T UPB, LOB; /* obtained upper bound and lower bound */
-        T *x = nullptr, *step = nullptr, *Fvalues = nullptr;
+
+        /* P contains parts (hyperintervals on which search must be performed), P1 is for the next step */
+        BoxArena<T> P, P1;
+
+        /* buffers used by the grid evaluator */
+        struct Scratch {
+            snowgoose::VecStorage<T, N> mStep; /* step of grid in every dimension */
+            std::vector<T> mRing; /* values of the function in the last window grid nodes */
+            snowgoose::VecStorage<int, N> mDigits; /* digits of the current node number */
+            std::vector<T> mPts; /* block of grid nodes passed to the objective */
+            snowgoose::VecStorage<T, N> mXs; /* local min coordinates */
+            snowgoose::VecStorage<T, N> mXr; /* the best local min coordinates found by the thread */
+            std::vector<long long> mIdx; /* numbers of nodes in the block (nested mode) */
+            std::vector<T> mVb; /* values in the block */
+        };
+        std::vector<Scratch> scratch; /* one set of buffers per thread */
+
+        /* boxes of a TASKS worker: the owner takes them from the back, thieves from the front */
+        struct Worker {
+            BoxArena<T> mBoxes;
+            std::deque<int> mQueue;
+            /* protects the queue and the arena against thieves */
+            std::mutex mLock;
+        };
+        std::vector<std::unique_ptr<Worker> > workers;
+
+        /* boxes that exceed the memory limit */
+        SpillFile<T> spill;
+
+        /* time of the last checkpoint */
+        std::chrono::steady_clock::time_point lastCheckpoint;
+
+        /* Check if it is time to write a checkpoint */
+        bool checkpointDue() const {
+            if (mOptions.mCheckpointFile.empty())
+                return false;
+            const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastCheckpoint).count();
+            return t >= mOptions.mCheckpointInterval;
+        }
+
+        /*
+         * Write the boxes of P (all or the listed ones) and the record to the checkpoint file,
+         * errors are reported but don't stop the search
+         */
+        void saveCheckpoint(const T* xfound, bool evaluated, const std::vector<int>* ids) {
+            try {
+                Checkpoint<T>::save(mOptions.mCheckpointFile, nodes, evaluated, UPB, xfound, P, ids, &spill);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+            lastCheckpoint = std::chrono::steady_clock::now();
+        }
+
+        static int maxThreads() {
+#ifdef _OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        static int threadNum() {
+#ifdef _OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+        static bool inParallel() {
+#ifdef _OPENMP
+            return omp_in_parallel();
+#else
+            return false;
+#endif
+        }
+
+        /* Search keeping boxes in a priority queue ordered by the lower bound */
+        T searchBestFirst(T* xfound, const BatchFunction &f, bool evaluated) {
+            Scratch& s = scratch[0];
+            /* (local lower bound, box) pairs, the top is the box with the least lower bound */
+            std::vector<std::pair<T, int> > queue;
+            const auto greater = std::greater<std::pair<T, int> >();
+
+            /* evaluate the i-th box and queue it if it is promising */
+            auto evaluate = [&](int i) {
+                T lUPB, lLOB, ldeltaL;
+                gridEvaluator(P.a(i), P.b(i), s.mXs.data(), &lUPB, &lLOB, &ldeltaL, f, s, nestedVals(P, i));
+                P.lo(i) = lLOB;
+                P.ub(i) = lUPB;
+                const T oldUPB = UPB;
+                updateRecords(lUPB, xfound, s.mXs.data());
+                if (UPB < oldUPB) {
+                    /* drop boxes that became non-promising */
+                    auto last = std::remove_if(queue.begin(), queue.end(), [&](const std::pair<T, int>& e) {
+                        if (e.first < (UPB - eps))
+                            return false;
+                        P.release(e.second);
+                        return true;
+                    });
+                    queue.erase(last, queue.end());
+                    std::make_heap(queue.begin(), queue.end(), greater);
+                }
+                if (lLOB < (UPB - eps)) {
+                    queue.emplace_back(lLOB, i);
+                    std::push_heap(queue.begin(), queue.end(), greater);
+                } else {
+                    P.release(i);
+                }
+            };
+
+            const int nboxes = P.size();
+            for (int i = 0; i < nboxes; i++) {
+                if (!evaluated) {
+                    evaluate(i);
+                } else if (P.lo(i) < (UPB - eps)) {
+                    queue.emplace_back(P.lo(i), i);
+                    std::push_heap(queue.begin(), queue.end(), greater);
+                } else {
+                    P.release(i);
+                }
+            }
+            /* numbers of queued boxes to save */
+            std::vector<int> ids;
+            auto save = [&]() {
+                ids.clear();
+                for (auto& e : queue)
+                    ids.push_back(e.second);
+                saveCheckpoint(xfound, true, &ids);
+            };
+            const long long limit = frontierLimit();
+            std::vector<int> loaded;
+            while ((!queue.empty() || !spill.empty()) && !this->stopped()) {
+                if (queue.empty()) {
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                    loadSpilled(limit / 2, loaded);
+                    for (int i : loaded)
+                        queue.emplace_back(P.lo(i), i);
+                    std::make_heap(queue.begin(), queue.end(), greater);
+                    continue;
+                }
+                if (checkpointDue())
+                    save();
+                std::pop_heap(queue.begin(), queue.end(), greater);
+                const int i = queue.back().second;
+                queue.pop_back();
+                int l, r;
+                try {
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                    subdivide(P, i, P, &l, &r);
+                    if (mOptions.mNested)
+                        inheritValues(P, i, P, l, r, f, s);
+                } catch (std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                    return UPB;
+                }
+                P.release(i);
+                evaluate(l);
+                evaluate(r);
+                /* move the boxes with the largest lower bounds to disk if the limit is exceeded */
+                if ((limit > 0) && ((long long) queue.size() > limit)) {
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                    const int keep = static_cast<int> (limit * 3 / 4);
+                    std::nth_element(queue.begin(), queue.begin() + keep, queue.end());
+                    try {
+                        for (auto e = queue.begin() + keep; e != queue.end(); e++) {
+                            spill.put(P, e->second);
+                            P.release(e->second);
+                        }
+                    } catch (std::exception& e) {
+                        std::cerr << e.what() << std::endl;
+                        return UPB;
+                    }
+                    queue.resize(keep);
+                    std::make_heap(queue.begin(), queue.end(), greater);
+                }
+                /* keep the boxes with the least lower bounds if there are too many */
+                if ((mOptions.mMaxBoxes > 0) && ((int) queue.size() > mOptions.mMaxBoxes)) {
+                    std::nth_element(queue.begin(), queue.begin() + mOptions.mMaxBoxes, queue.end());
+                    for (auto e = queue.begin() + mOptions.mMaxBoxes; e != queue.end(); e++)
+                        P.release(e->second);
+                    queue.resize(mOptions.mMaxBoxes);
+                    std::make_heap(queue.begin(), queue.end(), greater);
+                }
+            }
+            if (!mOptions.mCheckpointFile.empty())
+                save();
+            return UPB;
+        }
+
+        /*
+         * Branch-and-bound where every thread processes its own boxes depth-first
+         * and steals the oldest (largest) boxes of other threads when it runs out of work.
+         * The record is shared through an atomic so all threads prune with the latest one.
+         */
+        T searchTasks(T* xfound, const BatchFunction &f) {
+            const int nw = mOptions.mParallel ? maxThreads() : 1;
+            const int nvals = mOptions.mNested ? static_cast<int> (allnodes) : 0;
+            while ((int) workers.size() < nw)
+                workers.emplace_back(new Worker());
+            for (int w = 0; w < nw; w++) {
+                workers[w]->mBoxes.init(dim, nvals);
+                workers[w]->mQueue.clear();
+            }
+            const int nboxes = P.size();
+            for (int i = 0; i < nboxes; i++) {
+                Worker& w = *workers[i % nw];
+                w.mQueue.push_back(copyBox(P, i, w.mBoxes));
+            }
+            P.clear();
+
+            std::atomic<T> record(UPB);
+            std::mutex recordLock;
+            /* boxes that are queued or being processed */
+            std::atomic<long long> outstanding(nboxes);
+
+#pragma omp parallel num_threads(nw) if (mOptions.mParallel)
+            {
+                const int t = threadNum();
+                Worker& own = *workers[t];
+                Scratch& s = scratch[t];
+                BoxArena<T>& boxes = own.mBoxes;
+                /* takes a box of this thread or steals one, returns -1 if there is no work at the moment */
+                auto take = [&]() {
+                    {
+                        std::lock_guard<std::mutex> lk(own.mLock);
+                        if (!own.mQueue.empty()) {
+                            const int i = own.mQueue.back();
+                            own.mQueue.pop_back();
+                            return i;
+                        }
+                    }
+                    for (int k = 1; k < nw; k++) {
+                        Worker& victim = *workers[(t + k) % nw];
+                        std::lock(victim.mLock, own.mLock);
+                        std::lock_guard<std::mutex> lv(victim.mLock, std::adopt_lock);
+                        std::lock_guard<std::mutex> lo(own.mLock, std::adopt_lock);
+                        if (!victim.mQueue.empty()) {
+                            const int j = victim.mQueue.front();
+                            victim.mQueue.pop_front();
+                            const int i = copyBox(victim.mBoxes, j, boxes);
+                            victim.mBoxes.release(j);
+                            return i;
+                        }
+                    }
+                    return -1;
+                };
+
+                while ((outstanding.load() > 0) && !this->stopped()) {
+                    const int i = take();
+                    if (i < 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    T lUPB, lLOB, ldeltaL;
+                    gridEvaluator(boxes.a(i), boxes.b(i), s.mXs.data(), &lUPB, &lLOB, &ldeltaL, f, s, nestedVals(boxes, i));
+                    boxes.lo(i) = lLOB;
+                    boxes.ub(i) = lUPB;
+                    T cur = record.load();
+                    while ((lUPB < cur) && !record.compare_exchange_weak(cur, lUPB));
+                    if (lUPB < cur) {
+                        std::lock_guard<std::mutex> lk(recordLock);
+                        updateRecords(lUPB, xfound, s.mXs.data());
+                    }
+                    if (lLOB < (record.load() - eps)) {
+                        int l, r;
+                        {
+                            PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                            {
+                                std::lock_guard<std::mutex> lk(own.mLock);
+                                subdivide(boxes, i, boxes, &l, &r);
+                            }
+                            /* the halves are not queued yet so nobody else touches them */
+                            if (mOptions.mNested)
+                                inheritValues(boxes, i, boxes, l, r, f, s);
+                        }
+                        std::lock_guard<std::mutex> lk(own.mLock);
+                        boxes.release(i);
+                        own.mQueue.push_back(r);
+                        own.mQueue.push_back(l);
+                        outstanding += 1;
+                    } else {
+                        {
+                            std::lock_guard<std::mutex> lk(own.mLock);
+                            boxes.release(i);
+                        }
+                        outstanding -= 1;
+                    }
+                }
+            }
+            return UPB;
+        }
+
+        /*
+         * Branch-and-bound by forked worker processes (e.g. to isolate an objective that may crash).
+         * Workers take boxes from a stack in shared memory, process them depth-first
+         * and give away one half of every subdivided box while the stack has room.
+         * The record is kept in shared memory as well. If a worker dies its current box
+         * and the boxes it kept are dropped with a warning and a new worker is started.
+         * The nested mode is not supported: grid values are not passed between processes.
+         * The parent polls its workers every millisecond and, if the search has limits, the limits as well;
+         * when one is reached it tells workers to stop through the done flag.
+         * Fields of worker slots are written and read only under the pool lock.
+         * libgomp does not support fork() while its threads are active, so the engine refuses to start
+         * inside a parallel region, and OpenMP may not be used by workers (e.g. by parallelBatchify)
+         * if the parent process has already run parallel regions.
+         */
+        T searchProcesses(T* xfound, const BatchFunction &f) {
+            if (inParallel()) {
+                std::cerr << "GridLip: the PROCESSES engine can't be started inside an OpenMP parallel region" << std::endl;
+                return UPB;
+            }
+            const int nw = (mOptions.mProcesses > 0) ? mOptions.mProcesses : std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+            std::unique_ptr<SharedPool<T>> shared;
+            try {
+                shared.reset(new SharedPool<T>(dim, std::max(std::max(1, mOptions.mSharedBoxes), P.size()), nw));
+            } catch (std::exception& e) {
+                std::cerr << "GridLip: " << e.what() << std::endl;
+                return UPB;
+            }
+            SharedPool<T>& pool = *shared;
+            pool.setRecord(UPB);
+            std::copy(xfound, xfound + dim, pool.point());
+            for (int i = 0; i < P.size(); i++)
+                pool.push(P.a(i), P.b(i));
+            P.clear();
+            std::vector<pid_t> pids(nw);
+            auto spawn = [&](int w) {
+                std::cout.flush();
+                std::cerr.flush();
+                const pid_t pid = fork();
+                if (pid == 0) {
+                    processWorker(pool, w, f);
+                    _exit(0);
+                }
+                if (pid < 0)
+                    std::cerr << "GridLip: fork failed: " << strerror(errno) << std::endl;
+                pids[w] = pid;
+                return pid > 0;
+            };
+            int alive = 0;
+            for (int w = 0; w < nw; w++) {
+                if (spawn(w))
+                    alive++;
+            }
+            auto h = pool.header();
+            SearchControl* ctl = this->mControl;
+            /* evaluations of workers already counted in the control */
+            long long counted = 0;
+            auto count = [&]() {
+                const long long spent = __atomic_load_n(&h->mSpent, __ATOMIC_RELAXED);
+                ctl->addEvals(spent - counted);
+                counted = spent;
+            };
+            while (alive > 0) {
+                /* only the workers are waited for, other children of the process are left to their owners */
+                int status = 0, w = 0;
+                pid_t pid = 0;
+                for (; w < nw; w++) {
+                    if (pids[w] > 0) {
+                        pid = waitpid(pids[w], &status, WNOHANG);
+                        if (pid != 0)
+                            break;
+                    }
+                }
+                if (w == nw) {
+                    if (ctl != nullptr) {
+                        count();
+                        if (ctl->stopped() && !__atomic_load_n(&h->mDone, __ATOMIC_RELAXED)) {
+                            pool.lock();
+                            h->mDone = 1;
+                            pool.broadcast();
+                            pool.unlock();
+                        }
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                if (pid < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    /* the worker can't be waited for (e.g. SIGCHLD is ignored), its boxes are lost */
+                    std::cerr << "GridLip: can't wait for worker " << w << ": " << strerror(errno) << std::endl;
+                    pids[w] = -1;
+                    alive--;
+                    continue;
+                }
+                pids[w] = -1;
+                if (WIFEXITED(status) && (WEXITSTATUS(status) == 0)) {
+                    alive--;
+                    continue;
+                }
+                pool.lock();
+                auto slot = pool.slot(w);
+                if (slot->mBusy) {
+                    const T* cur = pool.current(w);
+                    std::cerr << "GridLip: worker " << w << " died, dropped box "
+                            << snowgoose::VecUtils::vecPrint(dim, cur) << " - " << snowgoose::VecUtils::vecPrint(dim, cur + dim)
+                            << " and " << slot->mLocal << " more boxes, the accuracy is not guaranteed" << std::endl;
+                }
+                slot->mBusy = 0;
+                slot->mLocal = 0;
+                if ((h->mCount == 0) && !pool.anyBusy())
+                    h->mDone = 1;
+                pool.broadcast();
+                const bool done = h->mDone;
+                pool.unlock();
+                if (done || !spawn(w))
+                    alive--;
+            }
+            /* the workers may exhaust the budget before the loop polls it, the reason is recorded here */
+            if (ctl != nullptr) {
+                count();
+                ctl->stopped();
+            }
+            if (h->mRecord < UPB) {
+                UPB = h->mRecord;
+                std::copy(pool.point(), pool.point() + dim, xfound);
+            }
+            PANTHER_STATS_DO(
+                this->mStats.mEvals += h->mEvals;
+                this->mStats.mCalls += h->mCalls;
+                this->mStats.mFuncTime += h->mFuncTime;
+                for (int k = 0; k < 3; k++)
+                    this->mStats.mPhaseTimes[k] += h->mPhaseTimes[k];
+            );
+            return UPB;
+        }
+
+        /* Main loop of a worker process */
+        void processWorker(SharedPool<T>& pool, int w, const BatchFunction &f) {
+            Scratch& s = scratch[0];
+            auto h = pool.header();
+            auto slot = pool.slot(w);
+            std::vector<int> stack;
+            P.init(dim, 0);
+            PANTHER_STATS_DO(this->mStats.reset({"evaluation", "lipschitz", "subdivision"}));
+            /* the copy of the control inherited from the parent counts evaluations of this worker */
+            const long long evals0 = (this->mControl != nullptr) ? this->mControl->evals() : 0;
+            long long evals = evals0;
+            while (true) {
+                /* the parent sets the flag when a limit of the search is reached */
+                if (__atomic_load_n(&h->mDone, __ATOMIC_RELAXED))
+                    break;
+                if (stack.empty()) {
+                    pool.lock();
+                    slot->mBusy = 0;
+                    slot->mLocal = 0;
+                    while ((h->mCount == 0) && !h->mDone) {
+                        if (!pool.anyBusy()) {
+                            h->mDone = 1;
+                            pool.broadcast();
+                            break;
+                        }
+                        pool.wait();
+                    }
+                    if (h->mDone) {
+                        pool.unlock();
+                        break;
+                    }
+                    const int i = P.add();
+                    pool.pop(P.a(i), P.b(i));
+                    slot->mBusy = 1;
+                    pool.unlock();
+                    stack.push_back(i);
+                }
+                const int i = stack.back();
+                stack.pop_back();
+                pool.lock();
+                slot->mLocal = stack.size();
+                std::copy(P.a(i), P.a(i) + dim, pool.current(w));
+                std::copy(P.b(i), P.b(i) + dim, pool.current(w) + dim);
+                pool.unlock();
+                T lUPB, lLOB, ldeltaL;
+                gridEvaluator(P.a(i), P.b(i), s.mXs.data(), &lUPB, &lLOB, &ldeltaL, f, s);
+                if (this->mControl != nullptr) {
+                    const long long e = this->mControl->evals();
+                    const long long spent = __atomic_add_fetch(&h->mSpent, e - evals, __ATOMIC_RELAXED);
+                    evals = e;
+                    /* the budget is checked here as well since the parent polls it with a delay */
+                    const long long budget = this->mControl->mMaxEvals;
+                    if ((budget > 0) && (evals0 + spent >= budget)) {
+                        pool.lock();
+                        h->mDone = 1;
+                        pool.broadcast();
+                        pool.unlock();
+                    }
+                }
+                if (lUPB < pool.record()) {
+                    pool.lock();
+                    if (lUPB < h->mRecord) {
+                        pool.setRecord(lUPB);
+                        std::copy(s.mXs.data(), s.mXs.data() + dim, pool.point());
+                    }
+                    pool.unlock();
+                }
+                if (lLOB < (pool.record() - eps)) {
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_SUBDIVISION]);
+                    int l, r;
+                    subdivide(P, i, P, &l, &r);
+                    P.release(i);
+                    pool.lock();
+                    if (pool.push(P.a(r), P.b(r))) {
+                        P.release(r);
+                        pool.broadcast();
+                    } else {
+                        stack.push_back(r);
+                    }
+                    pool.unlock();
+                    stack.push_back(l);
+                } else {
+                    P.release(i);
+                }
+            }
+            pool.lock();
+            PANTHER_STATS_DO(
+                h->mEvals += this->mStats.mEvals;
+                h->mCalls += this->mStats.mCalls;
+                h->mFuncTime += this->mStats.mFuncTime;
+                for (int k = 0; k < 3; k++)
+                    h->mPhaseTimes[k] += this->mStats.mPhaseTimes[k];
+            );
+            pool.unlock();
+        }
+
+        /* The number of boxes that fit the memory limit, 0 if there is no limit */
+        long long frontierLimit() const {
+            if (mOptions.mMemoryLimit == 0)
+                return 0;
+            /* bounds, local bounds and values in the pool, a queue entry and a free list entry */
+            const size_t box = sizeof (T) * (2 * dim + 2 + P.nvals()) + sizeof (std::pair<T, int>) + sizeof (int);
+            return std::max((long long) (mOptions.mMemoryLimit / box), 4LL);
+        }
+
+        /* Keep the given number of boxes of P with the least lower bounds in memory and spill the others, P stays dense */
+        void spillExcess(long long keep) {
+            std::vector<int> order(P.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::nth_element(order.begin(), order.begin() + keep, order.end(), [this](int u, int w) {
+                return P.lo(u) < P.lo(w);
+            });
+            /* the kept boxes retain their order */
+            std::sort(order.begin(), order.begin() + keep);
+            P1.clear();
+            for (long long k = 0; k < keep; k++)
+                copyBox(P, order[k], P1);
+            try {
+                for (size_t k = keep; k < order.size(); k++)
+                    spill.put(P, order[k]);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+            P.clear();
+            P.swap(P1);
+        }
+
+        /* Move up to count spilled boxes that are still promising to P */
+        void loadSpilled(long long count, std::vector<int>& ids) {
+            ids.clear();
+            spill.get(P, std::max(count, 1LL), [this](T lo) {
+                return lo < (UPB - eps);
+            }, ids);
+        }
+
+        /* Copy the i-th box of src with its values to dst, returns the number of the new box */
+        int copyBox(BoxArena<T>& src, int i, BoxArena<T>& dst) {
+            const int j = dst.add(src.a(i), src.b(i));
+            dst.lo(j) = src.lo(i);
+            dst.ub(j) = src.ub(i);
+            if (mOptions.mNested)
+                std::copy(src.vals(i), src.vals(i) + allnodes, dst.vals(j));
+            return j;
+        }
+
+        /* Subdivide the i-th box of src into two halves [a .. b1] [a1 .. b] along the longest side and add them to dst */
+        void subdivide(BoxArena<T>& src, int i, BoxArena<T>& dst, int* l, int* r) {
+            /* choose dimension (the longest side) */
+            const int choosen = chooseDim(src.a(i), src.b(i));
+            /* src and dst may coincide so bounds are taken after the new boxes are added */
+            *l = dst.add();
+            *r = dst.add();
+            std::copy(src.a(i), src.a(i) + dim, dst.a(*l));
+            std::copy(src.b(i), src.b(i) + dim, dst.b(*l));
+            std::copy(src.a(i), src.a(i) + dim, dst.a(*r));
+            std::copy(src.b(i), src.b(i) + dim, dst.b(*r));
+            /* where a1 = [a[1], a[2], .. ,a[choosen] + b[choosen]/2, .. , a[dim] ] */
+            /* and b1 = [b[1], b[2], .. ,a[choosen] + b[choosen]/2, .. , b[dim] ] */
+            const T mid = src.a(i)[choosen] + fabs(src.b(i)[choosen] - src.a(i)[choosen]) / 2.0;
+            dst.b(*l)[choosen] = mid;
+            dst.a(*r)[choosen] = mid;
+        }
+
+        /* Values of the i-th box used by the grid evaluator in the nested mode */
+        T* nestedVals(BoxArena<T>& boxes, int i) {
+            return mOptions.mNested ? boxes.vals(i) : nullptr;
+        }
+
+        /*
+         * Pass the grid values of the i-th box of src to its halves l and r in dst.
+         * The nodes of a half that coincide with the nodes of the parent grid get their values,
+         * other nodes are marked as unknown (NaN). For even number of nodes the common face of
+         * the halves doesn't belong to the parent grid so it is evaluated here once for both halves.
+         */
+        void inheritValues(BoxArena<T>& src, int i, BoxArena<T>& dst, int l, int r, const BatchFunction &f, Scratch& s) {
+            const T nan = std::numeric_limits<T>::quiet_NaN();
+            const int c = chooseDim(src.a(i), src.b(i));
+            const T* pv = src.vals(i);
+            T* lv = dst.vals(l);
+            T* rv = dst.vals(r);
+            /* distance between neighbour nodes along the c-th coordinate in the array of values */
+            const long long stride = powers[dim - 1 - c];
+            for (long long j = 0; j < allnodes; j++) {
+                const int u = (j / stride) % nodes;
+                /* the u-th node of the left half is the (u / 2)-th node of the parent */
+                lv[j] = (u % 2 == 0) ? pv[j + (u / 2 - u) * stride] : nan;
+                /* the u-th node of the right half is the ((nodes - 1 + u) / 2)-th node of the parent */
+                rv[j] = ((nodes - 1 + u) % 2 == 0) ? pv[j + ((nodes - 1 + u) / 2 - u) * stride] : nan;
+            }
+            if (nodes % 2 == 0) {
+                /* evaluate the common face as the last layer of the left half */
+                T* step = s.mStep.data();
+                const T* la = dst.a(l);
+                const T* lb = dst.b(l);
+                for (int k = 0; k < dim; k++)
+                    step[k] = fabs(lb[k] - la[k]) / (nodes - 1);
+                int m = 0;
+                auto flush = [&]() {
+                    f(m, s.mPts.data(), s.mVb.data());
+                    for (int q = 0; q < m; q++) {
+                        const long long j = s.mIdx[q];
+                        lv[j] = s.mVb[q];
+                        rv[j - (nodes - 1) * stride] = s.mVb[q];
+                    }
+                    m = 0;
+                };
+                for (long long j = 0; j < allnodes; j++) {
+                    if ((j / stride) % nodes == nodes - 1) {
+                        gridNode(j, la, step, s.mPts.data() + m * dim);
+                        s.mIdx[m++] = j;
+                        if (m == batch)
+                            flush();
+                    }
+                }
+                if (m > 0)
+                    flush();
+            }
+        }
+
+        /* The number of dimensions, constant if it is known at compile time */
+        int dimension() const {
+            return (N > 0) ? N : dim;
+        }
+
+        /* Coordinates of the j-th node of the grid with the given origin and steps */
+        void gridNode(long long j, const T* a, const T* step, T* xp) const {
+            const int nd = dimension();
+            long long point = j;
+            for (int k = nd - 1; k >= 0; k--) {
+                int t = point % nodes;
+                point = point / nodes;
+                xp[k] = a[k] + t * step[k];
+            }
+        }
 
         /* Get R (reliable coefficient) for the corresponding step lenght*/
         virtual double getR(const T delta) {
@@ -253,54 +1110,100 @@ namespace panther {
             return maxI;
         }
 
-        virtual void gridEvaluator(const T *a, const T *b, T* xfound, T *Frp, T *LBp, T *dL, const std::function<T(const T * const)> &compute) {
+        virtual void gridEvaluator(const T *a, const T *b, T* xfound, T *Frp, T *LBp, T *dL, const BatchFunction &compute, Scratch& s, T* vals = nullptr) {
+            const int nd = dimension();
+            T* step = s.mStep.data();
+            T* pts = s.mPts.data();
+            T* ring = s.mRing.data();
+            int* digit = s.mDigits.data();
             T Fr = std::numeric_limits<T>::max(), L = std::numeric_limits<T>::min(), delta = 0, LB;
             double R;
-            for (int i = 0; i < dim; i++) {
+            for (int i = 0; i < nd; i++) {
                 step[i] = fabs(b[i] - a[i]) / (nodes - 1);
                 delta += 0.5 * step[i];
             }
             R = getR(delta);
-            int node = 0;
-            /* Calculate and cache the value of the function in all points of the grid */
-            for (int j = 0; j < allnodes; j++) {
-                int point = j;
-                for (int k = dim - 1; k >= 0; k--) {
-                    int t = point % nodes;
-                    point = (int) (point / nodes);
-                    x[k] = a[k] + t * step[k];
-                }
-                T rs = compute(x);
-                Fvalues[j] = rs;
-                /* also remember minimum value across the grid */
-                if (rs < Fr) {
-                    Fr = rs;
+            long long node = 0;
+
+            /*
+             * Values are processed in the order of nodes in one pass: the minimum is remembered
+             * and the Lipshitz constant is estimated by differences with the preceding neighbours
+             * along every coordinate. The preceding neighbours are at most one layer (window nodes)
+             * behind so only the last layer is kept in the ring.
+             */
+            long long j = 0, pos = 0;
+            std::fill(digit, digit + nd, 0);
+            auto process = [&](T v) {
+                if (v < Fr) {
+                    Fr = v;
                     node = j;
                 }
-            }
-
-
-            /* Calculate coordinates of obtained upper bound */
-
-            for (int k = dim - 1; k >= 0; k--) {
-                int t = node % nodes;
-                node = (int) (node / nodes);
-                xfound[k] = a[k] + t * step[k];
-            }
-
-            /* Calculate all estimations of Lipshitz constant and choose maximum estimation */
-            for (int j = 0; j < allnodes; j++) {
-                int neighbour;
-                for (int k = 0; k < dim; k++) {
-                    int board = (int) pow(nodes, k + 1);
-                    neighbour = j + board / nodes;
-                    if ((neighbour < allnodes) && ((j / board) == (neighbour / board))) {
-                        T loc = fabs(Fvalues[j] - Fvalues[neighbour]) / step[dim - 1 - k];
+                for (int k = 0; k < nd; k++) {
+                    /* digit[k] is the node position along the (dim - 1 - k)-th coordinate */
+                    if (digit[k] > 0) {
+                        long long npos = pos - powers[k];
+                        if (npos < 0)
+                            npos += window;
+                        T loc = fabs(v - ring[npos]) / step[nd - 1 - k];
                         L = loc > L ? loc : L;
                     }
                 }
+                ring[pos] = v;
+                if (++pos == window)
+                    pos = 0;
+                j++;
+                for (int k = 0; k < nd; k++) {
+                    if (++digit[k] < nodes)
+                        break;
+                    digit[k] = 0;
+                }
+            };
+
+            /* Calculate the value of the function in all points of the grid block by block */
+            if (vals == nullptr) {
+                for (long long j0 = 0; j0 < allnodes; j0 += batch) {
+                    const int m = static_cast<int> (std::min((long long) batch, allnodes - j0));
+                    {
+                        PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_EVALUATION]);
+                        for (int q = 0; q < m; q++)
+                            gridNode(j0 + q, a, step, pts + q * nd);
+                        compute(m, pts, s.mVb.data());
+                    }
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_LIPSCHITZ]);
+                    for (int q = 0; q < m; q++)
+                        process(s.mVb[q]);
+                }
+            } else {
+                /* in the nested mode values are kept with the box and only unknown (NaN) ones are computed */
+                {
+                    PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_EVALUATION]);
+                    int m = 0;
+                    auto flush = [&]() {
+                        compute(m, pts, s.mVb.data());
+                        for (int q = 0; q < m; q++)
+                            vals[s.mIdx[q]] = s.mVb[q];
+                        m = 0;
+                    };
+                    for (long long i = 0; i < allnodes; i++) {
+                        if (std::isnan(vals[i])) {
+                            gridNode(i, a, step, pts + m * nd);
+                            s.mIdx[m++] = i;
+                            if (m == batch)
+                                flush();
+                        }
+                    }
+                    if (m > 0)
+                        flush();
+                }
+                PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_LIPSCHITZ]);
+                for (long long i = 0; i < allnodes; i++)
+                    process(vals[i]);
             }
 
+            /* Calculate coordinates of obtained upper bound */
+
+            gridNode(node, a, step, xfound);
+
             /* final calculation */
 
             LB = R * L * delta;
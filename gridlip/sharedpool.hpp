@@ -0,0 +1,192 @@
+/*
+ * File:   sharedpool.hpp
+ * Author: posypkin
+ *
+ * Pool of boxes shared by worker processes
+ */
+
+#ifndef SHAREDPOOL_HPP
+#define SHAREDPOOL_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <sys/mman.h>
+
+namespace panther {
+
+    /**
+     * A bounded stack of boxes with the record value and point placed in anonymous shared memory,
+     * so it is inherited by processes forked after its creation.
+     * The mutex is robust: if a process dies holding it the next owner gets it in a consistent state.
+     * Every worker has a slot with the box it is processing, so the parent
+     * can report what was lost when a worker crashes.
+     */
+    template <class T> class SharedPool {
+    public:
+
+        /* shared state */
+        struct Header {
+            pthread_mutex_t mLock;
+            pthread_cond_t mCond;
+            /* the number of boxes in the stack */
+            int mCount;
+            /* set when the search is over */
+            int mDone;
+            /* the record value */
+            T mRecord;
+            /* evaluations made by workers, updated after every box */
+            long long mSpent;
+            /* statistics collected by workers (phases are the ones of GridLip) */
+            long long mEvals;
+            long long mCalls;
+            double mFuncTime;
+            double mPhaseTimes[3];
+        };
+
+        /* state of a worker, accessed under the lock */
+        struct Slot {
+            /* the worker has boxes to process */
+            int mBusy;
+            /* the number of boxes kept by the worker besides the current one */
+            int mLocal;
+        };
+
+        /**
+         * Constructor
+         * @param n the number of dimensions
+         * @param capacity the maximal number of boxes in the stack
+         * @param workers the number of workers
+         */
+        SharedPool(int n, int capacity, int workers) : mDim(n), mCapacity(capacity), mWorkers(workers) {
+            mPointOff = align(sizeof (Header));
+            mSlotOff = align(mPointOff + n * sizeof (T));
+            mCurOff = align(mSlotOff + workers * sizeof (Slot));
+            mBoxOff = align(mCurOff + workers * 2 * n * sizeof (T));
+            mSize = mBoxOff + (size_t) capacity * 2 * n * sizeof (T);
+            void* p = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::runtime_error(std::string("mmap failed: ") + strerror(errno));
+            mMem = static_cast<char*> (p);
+            Header* h = header();
+            pthread_mutexattr_t ma;
+            pthread_mutexattr_init(&ma);
+            pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST);
+            pthread_mutex_init(&h->mLock, &ma);
+            pthread_mutexattr_destroy(&ma);
+            pthread_condattr_t ca;
+            pthread_condattr_init(&ca);
+            pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+            pthread_cond_init(&h->mCond, &ca);
+            pthread_condattr_destroy(&ca);
+        }
+
+        SharedPool(const SharedPool&) = delete;
+        SharedPool& operator=(const SharedPool&) = delete;
+
+        ~SharedPool() {
+            pthread_cond_destroy(&header()->mCond);
+            pthread_mutex_destroy(&header()->mLock);
+            munmap(mMem, mSize);
+        }
+
+        void lock() {
+            if (pthread_mutex_lock(&header()->mLock) == EOWNERDEAD)
+                pthread_mutex_consistent(&header()->mLock);
+        }
+
+        void unlock() {
+            pthread_mutex_unlock(&header()->mLock);
+        }
+
+        /* waits for a broadcast, the lock should be held */
+        void wait() {
+            if (pthread_cond_wait(&header()->mCond, &header()->mLock) == EOWNERDEAD)
+                pthread_mutex_consistent(&header()->mLock);
+        }
+
+        void broadcast() {
+            pthread_cond_broadcast(&header()->mCond);
+        }
+
+        /**
+         * Puts a box to the stack, the lock should be held
+         * @return false if the stack is full
+         */
+        bool push(const T* a, const T* b) {
+            Header* h = header();
+            if (h->mCount == mCapacity)
+                return false;
+            T* p = box(h->mCount++);
+            std::copy(a, a + mDim, p);
+            std::copy(b, b + mDim, p + mDim);
+            return true;
+        }
+
+        /* takes a box from a non-empty stack, the lock should be held */
+        void pop(T* a, T* b) {
+            const T* p = box(--header()->mCount);
+            std::copy(p, p + mDim, a);
+            std::copy(p + mDim, p + 2 * mDim, b);
+        }
+
+        /* true if some worker has boxes, the lock should be held */
+        bool anyBusy() {
+            for (int w = 0; w < mWorkers; w++) {
+                if (slot(w)->mBusy)
+                    return true;
+            }
+            return false;
+        }
+
+        /* the record value, may be read without the lock */
+        T record() {
+            T v;
+            __atomic_load(&header()->mRecord, &v, __ATOMIC_ACQUIRE);
+            return v;
+        }
+
+        /* sets the record value, the lock should be held */
+        void setRecord(T v) {
+            __atomic_store(&header()->mRecord, &v, __ATOMIC_RELEASE);
+        }
+
+        Header* header() {
+            return reinterpret_cast<Header*> (mMem);
+        }
+
+        /* the record point */
+        T* point() {
+            return reinterpret_cast<T*> (mMem + mPointOff);
+        }
+
+        Slot* slot(int w) {
+            return reinterpret_cast<Slot*> (mMem + mSlotOff) + w;
+        }
+
+        /* bounds (a then b) of the box processed by the w-th worker */
+        T* current(int w) {
+            return reinterpret_cast<T*> (mMem + mCurOff) + 2 * mDim * w;
+        }
+
+    private:
+
+        static size_t align(size_t off) {
+            return (off + 63) / 64 * 64;
+        }
+
+        T* box(int i) {
+            return reinterpret_cast<T*> (mMem + mBoxOff) + 2 * mDim * i;
+        }
+
+        int mDim, mCapacity, mWorkers;
+        size_t mPointOff, mSlotOff, mCurOff, mBoxOff, mSize;
+        char* mMem;
+    };
+}
+
+#endif /* SHAREDPOOL_HPP */
@@ -0,0 +1,179 @@
+/*
+ * File:   spillfile.hpp
+ * Author: posypkin
+ *
+ * On-disk queue of boxes
+ */
+
+#ifndef SPILLFILE_HPP
+#define SPILLFILE_HPP
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "boxarena.hpp"
+
+namespace panther {
+
+    /**
+     * A first-in first-out queue of boxes in a temporary file.
+     * Every box is a record of 2 * dim + 2 + nvals values: bounds (a then b), local lower
+     * and upper bounds and the values attached to the box. Records are appended and read
+     * sequentially, the file space is reused when the queue becomes empty.
+     */
+    template <class T> class SpillFile {
+    public:
+
+        SpillFile() {
+        }
+
+        SpillFile(const SpillFile&) = delete;
+        SpillFile& operator=(const SpillFile&) = delete;
+
+        ~SpillFile() {
+            if (mFile != nullptr)
+                fclose(mFile);
+        }
+
+        /**
+         * Prepares an empty queue
+         * @param n the number of dimensions
+         * @param m the number of values per box
+         */
+        void init(int n, int m) {
+            mDim = n;
+            mVals = m;
+            mLen = 2 * n + 2 + m;
+            mRead = mWrite = 0;
+            mMode = NONE;
+            mBuf.resize(mLen * CHUNK);
+        }
+
+        /**
+         * Appends a box
+         * @param boxes the pool
+         * @param i the number of the box
+         */
+        void put(BoxArena<T>& boxes, int i) {
+            open();
+            if (mMode != WRITING) {
+                seek(mWrite);
+                mMode = WRITING;
+            }
+            write(boxes.a(i), 2 * mDim);
+            write(&boxes.lo(i), 1);
+            write(&boxes.ub(i), 1);
+            write(boxes.vals(i), mVals);
+            mWrite++;
+        }
+
+        /**
+         * Takes boxes from the head of the queue and adds the ones to keep to the pool
+         * @param boxes the pool
+         * @param count the maximal number of boxes to take
+         * @param keep keep(lo) is true if the box with the local lower bound lo should be kept
+         * @param added the numbers of added boxes in the pool
+         */
+        template <class Keep> void get(BoxArena<T>& boxes, long long count, Keep keep, std::vector<int>& added) {
+            count = std::min(count, size());
+            for (long long k = 0; k < count; k += CHUNK) {
+                const int m = std::min((long long) CHUNK, count - k);
+                const T* rec = read(m);
+                for (int q = 0; q < m; q++, rec += mLen) {
+                    const T lo = rec[2 * mDim];
+                    if (!keep(lo))
+                        continue;
+                    const int i = boxes.add(rec, rec + mDim);
+                    boxes.lo(i) = lo;
+                    boxes.ub(i) = rec[2 * mDim + 1];
+                    std::copy(rec + 2 * mDim + 2, rec + mLen, boxes.vals(i));
+                    added.push_back(i);
+                }
+            }
+            if (mRead == mWrite)
+                mRead = mWrite = 0;
+        }
+
+        /**
+         * Passes all queued records to fn without taking them
+         * @param fn called with a pointer to every record
+         */
+        template <class Fn> void scan(Fn fn) {
+            const long long head = mRead;
+            for (long long k = mRead; k < mWrite; k += CHUNK) {
+                const int m = std::min((long long) CHUNK, mWrite - k);
+                const T* rec = read(m);
+                for (int q = 0; q < m; q++, rec += mLen)
+                    fn(rec);
+            }
+            mRead = head;
+            mMode = NONE;
+        }
+
+        /* the number of queued boxes */
+        long long size() const {
+            return mWrite - mRead;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        /* the number of values in a record */
+        int recordLength() const {
+            return mLen;
+        }
+
+    private:
+
+        enum Mode {
+            NONE, READING, WRITING
+        };
+
+        /* records read at once */
+        static constexpr int CHUNK = 1024;
+
+        void open() {
+            if (mFile == nullptr) {
+                mFile = tmpfile();
+                if (mFile == nullptr)
+                    throw std::runtime_error(std::string("can't create a spill file: ") + strerror(errno));
+                setvbuf(mFile, nullptr, _IOFBF, 1 << 20);
+            }
+        }
+
+        void seek(long long rec) {
+            if (fseeko(mFile, (off_t) rec * mLen * sizeof (T), SEEK_SET) != 0)
+                throw std::runtime_error(std::string("spill file seek failed: ") + strerror(errno));
+        }
+
+        void write(const T* p, int len) {
+            if (fwrite(p, sizeof (T), len, mFile) != (size_t) len)
+                throw std::runtime_error(std::string("spill file write failed: ") + strerror(errno));
+        }
+
+        /* reads m records at the head into the buffer */
+        const T* read(int m) {
+            if (mMode != READING) {
+                seek(mRead);
+                mMode = READING;
+            }
+            if (fread(mBuf.data(), sizeof (T) * mLen, m, mFile) != (size_t) m)
+                throw std::runtime_error("spill file read failed");
+            mRead += m;
+            return mBuf.data();
+        }
+
+        FILE* mFile = nullptr;
+        int mDim = 0, mVals = 0, mLen = 0;
+        long long mRead = 0, mWrite = 0;
+        Mode mMode = NONE;
+        std::vector<T> mBuf;
+    };
+}
+
+#endif /* SPILLFILE_HPP */
@@ -6,17 +6,60 @@
 
 #include <iostream>
 #include <iterator>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <chrono>
 #include "gridlip.hpp"
 
 constexpr int n = 3;
 
 double f(const double* x) {
-    double v;
+    double v = 0;
     for(int i = 0; i < n; i ++)
         v += x[i] * x[i];
     return v;
 }
 
+/* multimodal function to compare engines */
+double g(const double* x) {
+    double v = 0;
+    for (int i = 0; i < n; i++)
+        v += x[i] * x[i] + 0.5 * sin(5 * x[i]);
+    return v;
+}
+
+/* the objective slowed down to test the time limits */
+double slow(const double* x) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    return g(x);
+}
+
+using GridLip = panther::GridLip<double>;
+using Control = panther::SearchControl;
+
+int fails = 0;
+
+/* checks that the control stopped the search for the reason within the budget plus slack evaluations */
+void checkStopped(const Control& ctl, Control::Reason reason, long long slack, double v, double fx, const char* what) {
+    const bool ok = (ctl.reason() == reason) && ((ctl.mMaxEvals == 0) || (ctl.evals() <= ctl.mMaxEvals + slack)) && (fx == v);
+    std::cout << what << ": " << v << " after " << ctl.evals() << " evaluations " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
+/* runs the search for g and checks that it finds the reference value */
+double compare(GridLip& gl, const char* what, double ref) {
+    double x[n];
+    double a[n], b[n];
+    std::fill(a, a + n, -1.01);
+    std::fill(b, b + n, 2.57);
+    const double v = gl.search(n, x, a, b, g);
+    const bool ok = (v == ref) && (g(x) == v);
+    std::cout << what << ": " << v << " in " << gl.getStats().mEvals << " evaluations " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+    return v;
+}
+
 int main() {
     panther::GridLip<double> gridlip;
     gridlip.mOptions.mEps = 1e-3;
@@ -24,8 +67,103 @@ int main() {
     double a[n], b[n];
     std::fill(a, a + n, -1.01);
     std::fill(b, b + n, 2.57);
-    double v = gridlip.search(n, x, a, b, f);
+    /* the control without limits counts evaluations even if statistics are compiled out */
+    panther::SearchControl count;
+    double v = gridlip.search(n, x, a, b, f, count);
     std::cout << "Found " << v << " at [" ;
     std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
     std::cout << "]\n";
+    std::cout << gridlip.getStats().toString();
+
+    /* the same search limited to a quarter of evaluations, a box (nodes^n points) is not split */
+    const long long box = std::pow(gridlip.mOptions.mNodes, n);
+    Control ctl;
+    ctl.mMaxEvals = count.evals() / 4;
+    v = gridlip.search(n, x, a, b, f, ctl);
+    checkStopped(ctl, Control::BUDGET, box, v, f(x), "budget");
+
+    /* workers of the PROCESSES engine finish their current boxes */
+    gridlip.mOptions.mEngine = GridLip::PROCESSES;
+    gridlip.mOptions.mProcesses = 2;
+    ctl.reset();
+    v = gridlip.search(n, x, a, b, f, ctl);
+    checkStopped(ctl, Control::BUDGET, 2 * box, v, f(x), "budget of processes");
+    gridlip.mOptions.mEngine = GridLip::BFS;
+
+    /* the slow objective takes seconds to finish the search */
+    gridlip.mOptions.mEps = 1e-4;
+    Control deadline;
+    deadline.setTimeLimit(0.05);
+    v = gridlip.search(n, x, a, b, slow, deadline);
+    checkStopped(deadline, Control::DEADLINE, 0, v, g(x), "deadline");
+
+    gridlip.mOptions.mEngine = GridLip::BEST_FIRST;
+    Control cancel;
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        cancel.cancel();
+    });
+    v = gridlip.search(n, x, a, b, slow, cancel);
+    canceller.join();
+    checkStopped(cancel, Control::CANCELLED, 0, v, g(x), "cancelled by another thread");
+    gridlip.mOptions.mEngine = GridLip::BFS;
+
+    /* all engines and modes should find the value found by BFS */
+    GridLip gl;
+    gl.mOptions.mEps = 1e-3;
+    double a3[n], b3[n];
+    std::fill(a3, a3 + n, -1.01);
+    std::fill(b3, b3 + n, 2.57);
+    const double ref = gl.search(n, x, a3, b3, g);
+    std::cout << "BFS: " << ref << "\n";
+    panther::GridLip<double, n> fixed;
+    fixed.mOptions.mEps = 1e-3;
+    const double vf = fixed.search(n, x, a3, b3, g);
+    std::cout << "fixed dimension: " << vf << " " << (vf == ref ? "OK" : "FAILED") << "\n";
+    fails += (vf != ref);
+    gl.mOptions.mNested = true;
+    compare(gl, "BFS nested", ref);
+    gl.mOptions.mNested = false;
+    gl.mOptions.mEngine = GridLip::BEST_FIRST;
+    compare(gl, "best-first", ref);
+    gl.mOptions.mMaxBoxes = 64;
+    compare(gl, "best-first with 64 boxes", ref);
+    gl.mOptions.mMaxBoxes = 0;
+    gl.mOptions.mEngine = GridLip::TASKS;
+    compare(gl, "tasks", ref);
+    gl.mOptions.mNested = true;
+    compare(gl, "tasks nested", ref);
+    gl.mOptions.mNested = false;
+    gl.mOptions.mEngine = GridLip::PROCESSES;
+    gl.mOptions.mProcesses = 2;
+    compare(gl, "processes", ref);
+    gl.mOptions.mEngine = GridLip::BFS;
+
+    /* a search stopped by the budget is finished from its checkpoint */
+    const char* chk = "testgridlip.chk";
+    gl.mOptions.mCheckpointFile = chk;
+    gl.mOptions.mCheckpointInterval = 0;
+    for (auto engine : {GridLip::BFS, GridLip::BEST_FIRST}) {
+        gl.mOptions.mEngine = engine;
+        panther::SearchControl stop;
+        stop.mMaxEvals = 30000;
+        gl.search(n, x, a3, b3, g, stop);
+        const double v = gl.resume(n, x, chk, g);
+        const bool ok = (stop.reason() == panther::SearchControl::BUDGET) && (v == ref) && (g(x) == v);
+        std::cout << (engine == GridLip::BFS ? "BFS" : "best-first") << " resumed after " << stop.evals()
+                << " evaluations: " << v << " " << (ok ? "OK" : "FAILED") << "\n";
+        fails += !ok;
+    }
+    std::remove(chk);
+    gl.mOptions.mCheckpointFile.clear();
+
+    /* 4 KB hold a few dozen boxes, the rest of the frontier goes to disk */
+    gl.mOptions.mMemoryLimit = 4096;
+    gl.mOptions.mEngine = GridLip::BFS;
+    compare(gl, "BFS with spilled boxes", ref);
+    gl.mOptions.mEngine = GridLip::BEST_FIRST;
+    compare(gl, "best-first with spilled boxes", ref);
+    gl.mOptions.mMemoryLimit = 0;
+    gl.mOptions.mEngine = GridLip::BFS;
+    return fails ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+/*
+ * File:   multistart.hpp
+ * Author: mikhail
+ *
+ * Multi-start driver for local solvers
+ */
+
+#ifndef MULTISTART_HPP
+#define MULTISTART_HPP
+
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <cmath>
+#include <common/bbsolver.hpp>
+#include <common/vec.hpp>
+#include <common/lowdisc.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace panther {
+
+    /**
+     * Runs a local solver from many starting points taken from the Halton sequence in the box
+     * and keeps the best result. Runs that converge to the same point are merged into one basin.
+     */
+    template <class T> class MultiStart : public BlackBoxSolver <T> {
+    public:
+
+        /**
+         * Makes a new local solver
+         */
+        using Factory = std::function<std::unique_ptr<BlackBoxSolver<T>>()>;
+
+        struct Options {
+            // Number of starting points
+            int mStarts = 64;
+            // Run local searches by several OpenMP threads (the objective should be thread-safe)
+            bool mParallel = false;
+            // Results closer than this distance (relative to the box size along each coordinate) belong to one basin
+            T mBasinRadius = 1e-3;
+            // Stop as soon as the incumbent value is not greater than the target
+            T mTarget = -std::numeric_limits<T>::max();
+            // Stop after this number of local searches in a row did not improve the incumbent (0 - never)
+            int mMaxStall = 0;
+        } mOptions;
+
+        /**
+         * Local minimum found by one or several runs
+         */
+        struct Basin {
+            // the best point found in the basin
+            std::vector<T> mX;
+            // the value at the point
+            T mValue;
+            // the number of runs that ended in the basin
+            int mHits;
+        };
+
+        /**
+         * Constructor
+         * @param factory makes local solvers (one per thread)
+         */
+        MultiStart(const Factory& factory) : mFactory(factory) {
+        }
+
+        using BlackBoxSolver<T>::search;
+
+        T search(int n, T* x, const T * const a, const T * const b, const std::function<T(const T * const)> &func) override {
+            PANTHER_STATS_DO(this->mStats.reset({"local search", "basins"}));
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            const std::function<T(const T * const)> f = this->instrument(n, func);
+            const int nthreads = mOptions.mParallel ? maxThreads() : 1;
+            /* solvers are made beforehand as the factory is not required to be thread-safe */
+            while ((int) mSolvers.size() < nthreads)
+                mSolvers.push_back(mFactory());
+            mBasins.clear();
+            snowgoose::Halton halton(n);
+            T fr = std::numeric_limits<T>::max();
+            int stall = 0;
+            std::atomic<bool> stop(false);
+#pragma omp parallel if (mOptions.mParallel)
+            {
+                BlackBoxSolver<T>& solver = *mSolvers[threadNum()];
+                std::vector<T> y(n);
+                /* local searches stop with this one, evaluations are counted here through f */
+                SearchControl local(this->mControl);
+#pragma omp for schedule(dynamic)
+                for (int k = 0; k < mOptions.mStarts; k++) {
+                    if (stop.load(std::memory_order_relaxed) || this->stopped())
+                        continue;
+                    halton.point(k, a, b, y.data());
+                    T v;
+                    {
+                        PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_LOCAL]);
+                        v = (this->mControl != nullptr) ? solver.search(n, y.data(), a, b, f, local) : solver.search(n, y.data(), a, b, f);
+                    }
+#pragma omp critical(panther_multistart)
+                    {
+                        PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_BASINS]);
+                        addToBasins(n, y.data(), v, a, b);
+                        if (v < fr) {
+                            fr = v;
+                            snowgoose::VecUtils::vecCopy(n, y.data(), x);
+                            stall = 0;
+                        } else {
+                            stall++;
+                        }
+                        if ((fr <= mOptions.mTarget) || ((mOptions.mMaxStall > 0) && (stall >= mOptions.mMaxStall)))
+                            stop = true;
+                    }
+                }
+            }
+            std::sort(mBasins.begin(), mBasins.end(), [](const Basin& u, const Basin & w) {
+                return u.mValue < w.mValue;
+            });
+            return fr;
+        }
+
+        /**
+         * Retrieve basins found by the last search sorted by values
+         * @return basins
+         */
+        const std::vector<Basin>& getBasins() const {
+            return mBasins;
+        }
+
+        std::string about() const {
+            std::ostringstream os;
+            os << "Multi-start search\n";
+            os << "options:\n";
+            os << "starts = " << mOptions.mStarts << "\n";
+            os << "basin radius = " << mOptions.mBasinRadius << "\n";
+            os << "target = " << mOptions.mTarget << "\n";
+            os << "maximal stall = " << mOptions.mMaxStall << "\n";
+            os << (mOptions.mParallel ? "parallel starts\n" : "serial starts\n");
+            return os.str();
+        }
+
+    private:
+
+        /* phases of the search in statistics */
+        enum {
+            PHASE_LOCAL,
+            PHASE_BASINS
+        };
+
+        Factory mFactory;
+        std::vector<std::unique_ptr<BlackBoxSolver<T>>> mSolvers;
+        std::vector<Basin> mBasins;
+
+        /**
+         * Merges the result of a local search into the basin it belongs to or adds a new basin
+         * @param n dimension
+         * @param y the point
+         * @param v the value
+         * @param a lower bounds
+         * @param b upper bounds
+         */
+        void addToBasins(int n, const T* y, T v, const T* a, const T* b) {
+            const T r2 = mOptions.mBasinRadius * mOptions.mBasinRadius;
+            for (auto& bs : mBasins) {
+                T d2 = 0;
+                for (int i = 0; i < n; i++) {
+                    const T d = (y[i] - bs.mX[i]) / (b[i] - a[i]);
+                    d2 += d * d;
+                }
+                if (d2 <= r2) {
+                    bs.mHits++;
+                    if (v < bs.mValue) {
+                        bs.mValue = v;
+                        bs.mX.assign(y, y + n);
+                    }
+                    return;
+                }
+            }
+            mBasins.push_back({std::vector<T>(y, y + n), v, 1});
+        }
+
+        static int maxThreads() {
+#ifdef _OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        static int threadNum() {
+#ifdef _OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+    };
+}
+
+#endif /* MULTISTART_HPP */
@@ -0,0 +1,111 @@
+/* 
+ * File:   testmultistart.cpp
+ * Author: mikhail
+ */
+
+#include <iostream>
+#include <iterator>
+#include <cmath>
+#include <advcoordesc/advancedcoordescent.hpp>
+#include <rosenbrock/rosenbrockmethod.hpp>
+#include "multistart.hpp"
+
+constexpr int n = 2;
+
+/**
+ * Six-hump camel function: two global minima -1.0316 at (0.0898, -0.7126) and (-0.0898, 0.7126), six local minima in total
+ */
+double f(const double* x) {
+    const double x2 = x[0] * x[0];
+    return (4 - 2.1 * x2 + x2 * x2 / 3) * x2 + x[0] * x[1] + (-4 + 4 * x[1] * x[1]) * x[1] * x[1];
+}
+
+int fails = 0;
+
+void check(bool ok, const char* what) {
+    std::cout << what << ": " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
+/* the number of local searches made */
+int runs(const panther::MultiStart<double>& ms) {
+    int k = 0;
+    for (auto& bs : ms.getBasins())
+        k += bs.mHits;
+    return k;
+}
+
+/* basins are farther from each other than the radius along some coordinate */
+bool distinct(const panther::MultiStart<double>& ms, const double* a, const double* b) {
+    auto& bss = ms.getBasins();
+    for (size_t i = 0; i < bss.size(); i++)
+        for (size_t j = 0; j < i; j++) {
+            bool close = true;
+            for (int k = 0; k < n; k++)
+                close = close && (std::abs(bss[i].mX[k] - bss[j].mX[k]) <= ms.mOptions.mBasinRadius * (b[k] - a[k]));
+            if (close)
+                return false;
+        }
+    return true;
+}
+
+void report(const panther::MultiStart<double>& ms, double v, const double* x) {
+    std::cout << "Found " << v << " at [";
+    std::copy(x, x + n, std::ostream_iterator<double>(std::cout, " "));
+    std::cout << "]\n";
+    std::cout << "basins:\n";
+    for (auto& bs : ms.getBasins()) {
+        std::cout << bs.mValue << " at " << snowgoose::VecUtils::vecPrint(n, bs.mX.data()) << " hits " << bs.mHits << "\n";
+    }
+    std::cout << ms.getStats().toString();
+}
+
+int main(int argc, char** argv) {
+    double x[n];
+    double a[n] = {-3, -2}, b[n] = {3, 2};
+
+    panther::MultiStart<double> ms([]() {
+        auto s = new panther::AdvancedCoorDescent<double>();
+        s->mOptions.mMinStep = 1e-6;
+        return std::unique_ptr<BlackBoxSolver<double>>(s);
+    });
+    ms.mOptions.mStarts = 32;
+    ms.mOptions.mBasinRadius = 1e-2;
+    ms.mOptions.mParallel = true;
+    std::cout << ms.about();
+    double v = ms.search(n, x, a, b, f);
+    report(ms, v, x);
+    const double fmin = -1.0316284535;
+    check(std::abs(v - fmin) < 1e-6 && f(x) == v, "global minimum");
+    check(runs(ms) == ms.mOptions.mStarts && distinct(ms, a, b), "basins are merged");
+
+    /* every start gives the same local search in the serial mode */
+    ms.mOptions.mParallel = false;
+    const double vs = ms.search(n, x, a, b, f);
+    const size_t nb = ms.getBasins().size();
+    ms.mOptions.mParallel = true;
+    ms.search(n, x, a, b, f);
+    check(vs == v && nb == ms.getBasins().size(), "parallel starts give the serial result");
+
+    ms.mOptions.mMaxStall = 4;
+    v = ms.search(n, x, a, b, f);
+    check(runs(ms) < ms.mOptions.mStarts && f(x) == v, "stops after stalled starts");
+    ms.mOptions.mMaxStall = 0;
+
+    panther::MultiStart<double> msr([]() {
+        auto s = new panther::RosenbrockMethod<double>();
+        s->getOptions().mHInit.assign(n, 0.1);
+        s->getOptions().mHLB = 1e-6;
+        s->getOptions().mMinGrad = 1e-6;
+        s->getOptions().mMaxStepsNumber = 10000;
+        return std::unique_ptr<BlackBoxSolver<double>>(s);
+    });
+    msr.mOptions.mStarts = 32;
+    msr.mOptions.mBasinRadius = 1e-2;
+    msr.mOptions.mTarget = -1.03;
+    v = msr.search(n, x, a, b, f);
+    std::cout << "With target " << msr.mOptions.mTarget << ":\n";
+    report(msr, v, x);
+    check(v <= msr.mOptions.mTarget && runs(msr) < msr.mOptions.mStarts, "stops at the target");
+    return fails ? 1 : 0;
+}
@@ -9,10 +9,13 @@
 #include <sstream>
 #include <vector>
 #include <functional>
+#include <algorithm>
 #include <memory>
 #include <common/bbsolver.hpp>
 //#include <common/dummyls.hpp>
 #include <common/vec.hpp>
+#include <common/fixedvec.hpp>
+#include "tracesink.hpp"
 //#include <common/sgerrcheck.hpp>
 //#include <mpproblem.hpp>
 //#include <mputils.hpp>
@@ -25,10 +28,27 @@ namespace panther {
     /**
      * Rosenbrock method 
      * Description here: Rosenbrock, H. (1960). An automatic method for finding the greatest or least value of a function. The Computer Journal, 3(3), 175-184.
+     * @param N the number of variables if it is known at compile time, 0 otherwise
      */
-    template <typename FT> class RosenbrockMethod : public BlackBoxSolver<FT> {
+    template <typename FT, int N = 0> class RosenbrockMethod : public BlackBoxSolver<FT> {
     public:
 
+        /**
+         * Orthogonalization procedures
+         */
+        enum OrtMethod {
+            /**
+             * Classical Gram-Schmidt as in the original paper, O(n^3)
+             */
+            GRAM_SCHMIDT,
+            /**
+             * Palmer's procedure, O(n^2)
+             */
+            PALMER
+        };
+
+        using BatchFunction = typename BlackBoxSolver<FT>::BatchFunction;
+
         /**
          * Determines stopping conditions
          * @param fval current best value found
@@ -82,6 +102,10 @@ namespace panther {
              * Do ortoganization
              */
             bool mDoOrt = true;
+            /**
+             * Orthogonalization procedure
+             */
+            OrtMethod mOrtMethod = GRAM_SCHMIDT;
 
             /**
              * Total max steps number
@@ -91,26 +115,192 @@ namespace panther {
              * Trace on/off
              */
             bool mDoTracing = false;
+            /**
+             * Evaluate trial points along all directions concurrently (the objective should be thread-safe).
+             * Trials are accepted in the order of directions, so the trajectory is the same
+             * as in the serial mode but trials made after a successful one are wasted.
+             */
+            bool mParallelTrials = false;
         };
 
+        /**
+         * Working memory of the search
+         * Buffers grow to the largest dimension seen and are reused by subsequent searches,
+         * so repeated searches of the same or smaller size do not allocate.
+         * A workspace can be shared by several solvers that do not run simultaneously.
+         */
+        struct Workspace {
+            /**
+             * Ensures the buffers fit the problem
+             * @param n the number of variables
+             * @param width maximal number of trial points evaluated at once
+             */
+            void prepare(int n, int width) {
+                const int nsqr = n * n;
+                mDirs.resize(nsqr);
+                mA.resize(n);
+                mB.resize(nsqr);
+                mD.resize(nsqr);
+                mTrials.resize(width * n);
+                mFTrials.resize(width);
+                mInBox.resize(width);
+                mXn.resize(n);
+                mXOld.resize(n);
+            }
+
+            snowgoose::VecStorage<FT, N * N> mDirs, mB, mD, mTrials;
+            snowgoose::VecStorage<FT, N> mA, mFTrials, mXn, mXOld;
+            snowgoose::VecStorage<char, N> mInBox;
+            std::vector<FT> mSft, mStepLen;
+        };
+
+        RosenbrockMethod() : mWorkspace(std::make_shared<Workspace>()) {
+        }
+
         /**
          * Performs search
          * @param x start point and result
          * @param v  the resulting value
          * @return true if search converged and false otherwise
          */
+        using BlackBoxSolver<FT>::search;
+        using BlackBoxSolver<FT>::searchBatch;
+
         FT search(int n, FT* x, const FT* leftBound, const FT* rightBound, const std::function<FT ( const FT* )> &f) override {
-            const int nsqr = n * n;
+            if (mOptions.mParallelTrials)
+                return doSearch(n, x, leftBound, rightBound, BlackBoxSolver<FT>::parallelBatchify(n, f), n);
+            return doSearch(n, x, leftBound, rightBound, BlackBoxSolver<FT>::batchify(n, f), 1);
+        }
 
-            double v;
-            FT fcur = f(x);
-            FT xOld[n];
+        /**
+         * Performs search with a batch objective
+         * Trial points along all directions are submitted in one block.
+         * After a successful trial the rest of the block is discarded and recomputed
+         * from the new point, so the trajectory coincides with the one of search()
+         * at the cost of extra evaluations.
+         * @param x start point and result
+         * @param v  the resulting value
+         * @return the found value
+         */
+        FT searchBatch(int n, FT* x, const FT* leftBound, const FT* rightBound, const BatchFunction &f) override {
+            return doSearch(n, x, leftBound, rightBound, f, n);
+        }
 
-            std::vector<FT> sft(mOptions.mHInit);
-            std::vector<FT> stepLen(n, 0);
+        std::string about() const {
+            std::ostringstream os;
+            os << "Rosenbrock method\n";
+            os << "options:\n";
+            os << "decrement = " << mOptions.mDec << "\n";
+            os << "increment = " << mOptions.mInc << "\n";
+            os << "initial step size = [ ";
+            for(auto a : mOptions.mHInit) 
+                os << " " << a;
+            os << " ]\n";
+            os << "bounds on step size = [" << mOptions.mHLB << " " << mOptions.mHUB << "]\n";
+            os << "lower bound on gradient = " << mOptions.mMinGrad << "\n";
+            os << "maxima stages = " << mOptions.mMaxStepsNumber << "\n";
+            os << (mOptions.mDoOrt ? "do ortogonalization\n" : "don't do ortogonalization\n");
+            os << (mOptions.mOrtMethod == PALMER ? "Palmer ortogonalization\n" : "Gram-Schmidt ortogonalization\n");
+            os << (mOptions.mDoTracing ? "do tracing\n" : "don't do tracing\n");
+            os << (mOptions.mParallelTrials ? "parallel trials\n" : "serial trials\n");
+            return os.str();
+        }
+
+        /**
+         * Retrieve options
+         * @return options
+         */
+        Options & getOptions() {
+            return mOptions;
+        }
+
+        /**
+         * Retrieve stoppers vector reference
+         * @return stoppers vector reference
+         */
+        std::vector<Stopper>& getStoppers() {
+            return mStoppers;
+        }
+
+        /**
+         * Get watchers' vector
+         * @return watchers vector
+         */
+        std::vector<Watcher>& getWatchers() {
+            return mWatchers;
+        }
+
+        /**
+         * Sets the trace sink that records every stage (nullptr to stop tracing)
+         * The sink is cheaper than a watcher and is not owned by the solver.
+         * @param sink the sink
+         */
+        void setTraceSink(TraceSink<FT>* sink) {
+            mTrace = sink;
+        }
+
+        /**
+         * Sets the workspace (e.g. shared with other solvers)
+         * @param ws the workspace
+         */
+        void setWorkspace(const std::shared_ptr<Workspace>& ws) {
+            mWorkspace = ws;
+        }
+
+        /**
+         * Retrieve the workspace
+         * @return the workspace
+         */
+        const std::shared_ptr<Workspace>& getWorkspace() const {
+            return mWorkspace;
+        }
 
-            FT * dirs = new FT[nsqr];
-            snowgoose::VecUtils::vecSet(n * n, 0., dirs);
+    private:
+        /* vector operations for the dimension */
+        using VU = snowgoose::VecOps<N>;
+
+        /* the number of matrix elements processed by one block in the Gram-Schmidt procedure */
+        static constexpr int ORT_BLOCK = 4096;
+
+        /* phases of the search in statistics */
+        enum {
+            PHASE_STEP,
+            PHASE_ORTOGONALIZE
+        };
+
+        Options mOptions;
+        std::vector<Stopper> mStoppers;
+        std::vector<Watcher> mWatchers;
+        std::shared_ptr<Workspace> mWorkspace;
+        TraceSink<FT>* mTrace = nullptr;
+
+        /**
+         * Performs search
+         * @param x start point and result
+         * @param f batch objective
+         * @param width maximal number of trial points evaluated at once
+         * @return the found value
+         */
+        FT doSearch(int dim, FT* x, const FT* leftBound, const FT* rightBound, const BatchFunction &func, int width) {
+            PANTHER_STATS_DO(this->mStats.reset({"step", "orthogonalize"}));
+            PANTHER_STATS_TIMER(this->mStats.mTotalTime);
+            const BatchFunction f = this->instrument(dim, func);
+            const int n = snowgoose::checkDim<N>(dim);
+            const int nsqr = n * n;
+
+            double v;
+            FT fcur;
+            f(1, x, &fcur);
+
+            Workspace& ws = *mWorkspace;
+            ws.prepare(n, width);
+            std::vector<FT>& sft = ws.mSft;
+            std::vector<FT>& stepLen = ws.mStepLen;
+            sft.assign(mOptions.mHInit.begin(), mOptions.mHInit.end());
+            stepLen.assign(n, 0);
+
+            auto& dirs = ws.mDirs;
+            snowgoose::VecUtils::vecSet(nsqr, (FT) 0., dirs.data());
             for (int i = 0; i < n; i++) {
                 dirs[i * n + i] = 1;
             }
@@ -118,7 +308,7 @@ namespace panther {
             auto printDirs = [&dirs, n] () {
                 std::cout << "==== dirs ====\n";
                 for (int i = 0; i < n; i++) {
-                    FT* d = dirs + i * n;
+                    FT* d = dirs.data() + i * n;
                     std::cout << "[";
                     for (int j = 0; j < n; j++) {
                         std::cout << d[j] << " ";
@@ -128,9 +318,9 @@ namespace panther {
                 std::cout << "==============\n";
             };
 
-            FT * a = new FT[n];
-            FT * b = new FT[nsqr];
-            FT * d = new FT[nsqr];
+            auto& a = ws.mA;
+            auto& b = ws.mB;
+            auto& d = ws.mD;
 
             int stageNum = 1;
             bool br = false;
@@ -150,80 +340,96 @@ namespace panther {
                 return t;
             };
 
+            auto& trials = ws.mTrials;
+            auto& ftrials = ws.mFTrials;
+            auto& inbox = ws.mInBox;
+            auto& xn = ws.mXn;
+            auto& xold = ws.mXOld;
+
             /*
              * Attepmt yielding new minimum along each base direction.
+             * Trial points for up to width directions are evaluated at once.
              * @return true if step along at least one direction was successful
              */
             auto step = [&] () {
+                PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_STEP]);
                 bool isStepSuccessful = false;
-                FT xn[n];
-                snowgoose::VecUtils::vecCopy(n, x, xn);
-
-                for (int i = 0; i < n; i++) {
-                    const FT h = sft[i];
-                    FT xtmp[n];
-                    snowgoose::VecUtils::vecSaxpy(n, xn, &(dirs[i * n]), h, xtmp);
-                    if (isInBox(n, xtmp, leftBound, rightBound)) {
-                        FT ftmp = f(xtmp);
-
-                        if (ftmp < fcur) {
-                            isStepSuccessful = true;
-                            stepLen[i] += h;
-                            sft[i] = inc(h);
-                            snowgoose::VecUtils::vecCopy(n, xtmp, xn);
-                            fcur = ftmp;
+                VU::vecCopy(n, x, xn.data());
+
+                int i = 0;
+                /* the rest of directions is skipped if a limit of the search is reached */
+                while ((i < n) && !this->stopped()) {
+                    const int iend = std::min(n, i + width);
+                    int m = 0;
+                    for (int j = i; j < iend; j++) {
+                        FT* xtmp = trials.data() + m * n;
+                        VU::vecSaxpy(n, xn.data(), &(dirs[j * n]), sft[j], xtmp);
+                        inbox[j - i] = isInBox(n, xtmp, leftBound, rightBound);
+                        if (inbox[j - i])
+                            m++;
+                    }
+                    if (m > 0)
+                        f(m, trials.data(), ftrials.data());
+
+                    int k = 0;
+                    int inext = iend;
+                    for (int j = i; j < iend; j++) {
+                        const FT h = sft[j];
+                        if (inbox[j - i]) {
+                            const FT ftmp = ftrials[k];
+                            const FT* xtmp = trials.data() + k * n;
+                            k++;
+
+                            if (ftmp < fcur) {
+                                isStepSuccessful = true;
+                                stepLen[j] += h;
+                                sft[j] = inc(h);
+                                VU::vecCopy(n, xtmp, xn.data());
+                                fcur = ftmp;
+                                /* the remaining trials were made from the old point */
+                                inext = j + 1;
+                                break;
+                            } else {
+                                const FT nh = dec(std::abs(h));
+                                sft[j] = (h > 0) ? - nh : nh;
+                            }
                         } else {
                             const FT nh = dec(std::abs(h));
-                            sft[i] = (h > 0) ? - nh : nh;
+                            sft[j] = (h > 0) ? - nh : nh;
                         }
-                    } else {
-                        const FT nh = dec(std::abs(h));
-                        sft[i] = (h > 0) ? - nh : nh;
                     }
+                    i = inext;
                 }
 
-                snowgoose::VecUtils::vecCopy(n, xn, x);
+                VU::vecCopy(n, xn.data(), x);
                 return isStepSuccessful;
             };
 
             auto ortogonalize = [&] () {
-
-                for (int i = 0; i < n; i++) {
-                    if (stepLen[i] == 0) {
-                        snowgoose::VecUtils::vecCopy(n, &(dirs[i * n]), a);
-
-                    } else {
-                        snowgoose::VecUtils::vecSet(n, 0., a);
-                        for (int j = i; j < n; j++) {
-                            snowgoose::VecUtils::vecSaxpy(n, a, &(dirs[j * n]), stepLen[j], a);
-                        }
-                    }
-
-                    snowgoose::VecUtils::vecCopy(n, a, &(b[i * n]));
-
-                    for (int j = 0; j < i; j++) {
-                        FT scalarMlp = snowgoose::VecUtils::vecScalarMult(n, a, &(d[j * n]));
-                        snowgoose::VecUtils::vecSaxpy(n, &(b[i * n]), &(d[j * n]), -scalarMlp, &(b[i * n]));
-                    }
-
-                    FT norm = snowgoose::VecUtils::vecNormTwo(n, &(b[i * n]));
-                    snowgoose::VecUtils::vecMult(n, &(b[i * n]), 1 / norm, &(d[i * n]));
+                PANTHER_STATS_TIMER(this->mStats.mPhaseTimes[PHASE_ORTOGONALIZE]);
+                /* A_i = sum_{j >= i} stepLen[j] * dirs_j accumulated from the last direction */
+                VU::vecMult(n, &(dirs[(n - 1) * n]), stepLen[n - 1], &(b[(n - 1) * n]));
+                for (int i = n - 2; i >= 0; i--) {
+                    VU::vecSaxpy(n, &(b[(i + 1) * n]), &(dirs[i * n]), stepLen[i], &(b[i * n]));
                 }
-
-                for (int i = 0; i < n; i++) {
-                    snowgoose::VecUtils::vecCopy(n, &(d[i * n]), &(dirs[i * n]));
+                if (mOptions.mOrtMethod == PALMER) {
+                    palmer(n, stepLen.data(), dirs.data(), b.data(), a.data(), d.data());
+                } else {
+                    gramSchmidt(n, stepLen.data(), dirs.data(), b.data(), a.data(), d.data());
                 }
-
+                std::swap(d, dirs);
             };
 
+            if (mTrace != nullptr)
+                mTrace->begin(n);
+
             while (!br) {
-                FT der;
-                FT xold[n];
-                snowgoose::VecUtils::vecCopy(n, x, xold);
+                FT der = 0;
+                VU::vecCopy(n, x, xold.data());
                 const FT fold = fcur;
                 const bool success = step();
                 if(success) {
-                    const FT dist = snowgoose::VecUtils::vecDist(n, x, xold);
+                    const FT dist = VU::vecDist(n, x, xold.data());
                     der = (fold - fcur) / dist;
 //                    std::cout << "der = " << der << std::endl;
                     if(der < mOptions.mMinGrad) {
@@ -265,13 +471,22 @@ namespace panther {
 
                 if (stageNum >= mOptions.mMaxStepsNumber) {
                     br = true;
-                    std::cout << "Stopped as number of stages was too big\n";
+                    if (mOptions.mDoTracing)
+                        std::cout << "Stopped as number of stages was too big\n";
                 }
 
-                for (auto w : mWatchers) {
-                    w(fcur, x, sft, success, der, dirs, stageNum);
+                if (this->stopped()) {
+                    br = true;
+                    if (mOptions.mDoTracing)
+                        std::cout << "Stopped as a limit of the search was reached\n";
                 }
-                for (auto s : mStoppers) {
+
+                if (mTrace != nullptr)
+                    mTrace->record(stageNum, fcur, success, der, x, sft.data(), dirs.data());
+                for (const auto& w : mWatchers) {
+                    w(fcur, x, sft, success, der, dirs.data(), stageNum);
+                }
+                for (const auto& s : mStoppers) {
                     if (s(fcur, x, stageNum)) {
                         br = true;
                         break;
@@ -280,60 +495,82 @@ namespace panther {
             }
             v = fcur;
 
-            delete [] dirs;
-            delete [] a;
-            delete [] b;
-            delete [] d;
             return v;
         }
 
-        std::string about() const {
-            std::ostringstream os;
-            os << "Rosenbrock method\n";
-            os << "options:\n";
-            os << "decrement = " << mOptions.mDec << "\n";
-            os << "increment = " << mOptions.mInc << "\n";
-            os << "initial step size = [ ";
-            for(auto a : mOptions.mHInit) 
-                os << " " << a;
-            os << " ]\n";
-            os << "bounds on step size = [" << mOptions.mHLB << " " << mOptions.mHUB << "]\n";
-            os << "lower bound on gradient = " << mOptions.mMinGrad << "\n";
-            os << "maxima stages = " << mOptions.mMaxStepsNumber << "\n";
-            os << (mOptions.mDoOrt ? "do ortogonalization\n" : "don't do ortogonalization\n");
-            os << (mOptions.mDoTracing ? "do tracing\n" : "don't do tracing\n");
-            return os.str();
-        }
-
-        /**
-         * Retrieve options
-         * @return options
-         */
-        Options & getOptions() {
-            return mOptions;
-        }
-
         /**
-         * Retrieve stoppers vector reference
-         * @return stoppers vector reference
+         * Classical Gram-Schmidt orthogonalization of A_i (or of the old direction if its step is zero)
+         * Projections onto previous directions are computed by blocks of rows that stay in cache
+         * between computing scalar products and subtracting projections.
+         * @param n dimension
+         * @param len step lengths along directions
+         * @param dirs old directions
+         * @param sums A_i vectors
+         * @param coeff scratch of length n
+         * @param nd new directions
          */
-        std::vector<Stopper>& getStoppers() {
-            return mStoppers;
+        static void gramSchmidt(int n, const FT* len, const FT* dirs, const FT* sums, FT* coeff, FT* nd) {
+            const int bs = std::max(1, ORT_BLOCK / n);
+            for (int i = 0; i < n; i++) {
+                const FT* ai = (len[i] == 0) ? dirs + i * n : sums + i * n;
+                FT* bi = nd + i * n;
+                VU::vecCopy(n, ai, bi);
+                for (int jb = 0; jb < i; jb += bs) {
+                    const int je = std::min(i, jb + bs);
+                    for (int j = jb; j < je; j++) {
+                        const FT* dj = nd + j * n;
+                        FT s = 0;
+#pragma omp simd reduction(+:s)
+                        for (int k = 0; k < n; k++)
+                            s += ai[k] * dj[k];
+                        coeff[j] = s;
+                    }
+                    for (int j = jb; j < je; j++) {
+                        const FT* dj = nd + j * n;
+                        const FT c = coeff[j];
+#pragma omp simd
+                        for (int k = 0; k < n; k++)
+                            bi[k] -= c * dj[k];
+                    }
+                }
+                const FT norm = VU::vecNormTwo(n, bi);
+                VU::vecMult(n, bi, 1 / norm, bi);
+            }
         }
 
         /**
-         * Get watchers' vector
-         * @return watchers vector
+         * Palmer's O(n^2) form of the orthogonalization
+         * Palmer, J. R. (1969). An improved procedure for orthogonalising the search vectors in Rosenbrock's and Swann's direct search optimisation methods. The Computer Journal, 12(1), 69-71.
+         * d'_1 = A_1 / t_1, d'_i = (len_{i-1} A_i - d_{i-1} t_i^2) / (t_{i-1} t_i), where t_i^2 = sum_{j >= i} len_j^2,
+         * directions with t_i = 0 are kept. Unlike gramSchmidt() A_i is used for zero steps as well,
+         * so the directions may differ from it when some steps are zero.
+         * @param n dimension
+         * @param len step lengths along directions
+         * @param dirs old directions
+         * @param sums A_i vectors
+         * @param t scratch of length n
+         * @param nd new directions
          */
-        std::vector<Watcher>& getWatchers() {
-            return mWatchers;
+        static void palmer(int n, const FT* len, const FT* dirs, const FT* sums, FT* t, FT* nd) {
+            FT tsqr = 0;
+            for (int i = n - 1; i >= 0; i--) {
+                tsqr += len[i] * len[i];
+                t[i] = std::sqrt(tsqr);
+            }
+            for (int i = 0; i < n; i++) {
+                if (t[i] == 0) {
+                    VU::vecCopy(n, dirs + i * n, nd + i * n);
+                } else if (i == 0) {
+                    VU::vecMult(n, sums, 1 / t[0], nd);
+                } else {
+                    /* the sign agrees with the Gram-Schmidt procedure applied to A_i */
+                    const FT q = ((len[i - 1] < 0) ? -1 : 1) / (t[i - 1] * t[i]);
+                    VU::vecMult(n, sums + i * n, len[i - 1] * q, nd + i * n);
+                    VU::vecSaxpy(n, nd + i * n, dirs + (i - 1) * n, -t[i] * t[i] * q, nd + i * n);
+                }
+            }
         }
 
-    private:
-        Options mOptions;
-        std::vector<Stopper> mStoppers;
-        std::vector<Watcher> mWatchers;
-
         void printMatrix(const char * name, int n, int m, FT * matrix) {
             std::cout << name << " =\n";
             for (int i = 0; i < n; i++) {
@@ -4,7 +4,17 @@
  */
 
 #include <cstdlib>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <thread>
+#include <chrono>
 #include "rosenbrockmethod.hpp"
 
 using namespace std;
@@ -13,6 +23,70 @@ double func(const double* x) {
     return 100 * SGSQR(x[1] - x[0] * x[0]) + SGSQR(1 - x[1]);
 }
 
+/* the extended Rosenbrock function of 4 variables */
+double func4(const double* x) {
+    double v = 0;
+    for (int i = 0; i < 3; i++)
+        v += 100 * SGSQR(x[i + 1] - x[i] * x[i]) + SGSQR(1 - x[i]);
+    return v;
+}
+
+/* the objective slowed down to test the time limits */
+double slow4(const double* x) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    return func4(x);
+}
+
+using Control = panther::SearchControl;
+
+int fails = 0;
+
+void check(bool ok, const char* what) {
+    std::cout << what << ": " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
+/* checks that the control stopped the search for the reason within the budget plus slack evaluations */
+void checkStopped(const Control& ctl, Control::Reason reason, long long slack, double v, const double* x, const char* what) {
+    const bool ok = (ctl.reason() == reason) && ((ctl.mMaxEvals == 0) || (ctl.evals() <= ctl.mMaxEvals + slack)) && (func4(x) == v);
+    std::cout << what << ": " << v << " after " << ctl.evals() << " evaluations " << (ok ? "OK" : "FAILED") << "\n";
+    fails += !ok;
+}
+
+/* reads rows of the CSV printed by trace2csv for the trace file, returns false if the conversion failed */
+bool convertTrace(const char* file, std::vector<std::vector<double>>& rows) {
+    const std::string cmd = std::string("./trace2csv.exe ") + file + " 2>/dev/null";
+    FILE* p = popen(cmd.c_str(), "r");
+    if (p == nullptr)
+        return false;
+    char line[4096];
+    while (fgets(line, sizeof (line), p) != nullptr) {
+        if (line[0] == 'r')
+            continue;
+        std::vector<double> row;
+        std::istringstream is(line);
+        std::string cell;
+        while (std::getline(is, cell, ','))
+            row.push_back(std::stod(cell));
+        rows.push_back(row);
+    }
+    return pclose(p) == 0;
+}
+
+/* runs a solver for g from the same point, within the limits of the control if it is given */
+template <class Solver> double run4(Solver& s, double* x, double (*g)(const double*) = func4, Control* ctl = nullptr) {
+    const int n = 4;
+    double a[n], b[n];
+    std::fill(a, a + n, -4);
+    std::fill(b, b + n, 8);
+    std::fill(x, x + n, 3);
+    s.getOptions().mHInit.assign(n, 1.);
+    s.getOptions().mMaxStepsNumber = 10000;
+    s.getOptions().mMinGrad = 1e-6;
+    s.getOptions().mHLB = 1e-8;
+    return (ctl == nullptr) ? s.search(n, x, a, b, g) : s.search(n, x, a, b, g, *ctl);
+}
+
 int main(int argc, char** argv) {
     const int dim = 2;
     double x[dim] = {3, 3};
@@ -28,11 +102,115 @@ int main(int argc, char** argv) {
     searchMethod.getOptions().mMinGrad = 1e-3;
     searchMethod.getOptions().mHLB = searchMethod.getOptions().mMinGrad * 1e-2;
     
+    /* keep the last stages in memory */
+    panther::TraceSink<double> trace(16);
+    searchMethod.setTraceSink(&trace);
     double v = searchMethod.search(dim, x, a, b, func);
     
     std::cout << searchMethod.about() << "\n";
     std::cout << "Found v = " << v << "\n";
     std::cout << " at " << snowgoose::VecUtils::vecPrint(dim, x) << "\n";
-    return 0;
+    std::cout << searchMethod.getStats().toString();
+    std::cout << "Last stages:\n";
+    for (int k = 0; k < trace.size(); k++)
+        std::cout << trace.stage(k) << ": " << trace.value(k) << " at " << snowgoose::VecUtils::vecPrint(dim, trace.x(k)) << "\n";
+
+    /* the same search traced to a file by small chunks and to a ring that keeps all stages */
+    searchMethod.getOptions().mDoTracing = false;
+    const char* traceFile = "testrosenbrock.trace";
+    {
+        panther::TraceSink<double> sink(16, traceFile, true);
+        searchMethod.setTraceSink(&sink);
+        std::fill(x, x + dim, 3);
+        searchMethod.search(dim, x, a, b, func);
+    }
+    panther::TraceSink<double> all(1 << 16);
+    searchMethod.setTraceSink(&all);
+    std::fill(x, x + dim, 3);
+    searchMethod.search(dim, x, a, b, func);
+    searchMethod.setTraceSink(nullptr);
+    std::vector<std::vector<double>> rows;
+    bool same = convertTrace(traceFile, rows) && ((int) rows.size() == all.size());
+    for (int k = 0; same && k < all.size(); k++) {
+        const auto& r = rows[k];
+        same = (r.size() == 5 + 2 * dim + dim * dim) && (r[1] == all.stage(k)) && (r[2] == all.value(k))
+                && (r[3] == all.grad(k)) && (r[4] == all.success(k))
+                && std::equal(all.x(k), all.x(k) + dim, r.begin() + 5) && std::equal(all.gran(k), all.gran(k) + dim, r.begin() + 5 + dim);
+    }
+    check(same, "trace file converted to CSV matches the stages");
+    /* a file of another version or cut in the middle of a chunk is rejected */
+    auto setVersion = [traceFile](int32_t version) {
+        FILE* tf = fopen(traceFile, "r+b");
+        fseek(tf, 8, SEEK_SET);
+        fwrite(&version, sizeof (version), 1, tf);
+        fclose(tf);
+    };
+    setVersion(panther::TraceSink<double>::VERSION + 1);
+    rows.clear();
+    check(!convertTrace(traceFile, rows), "trace of another version is rejected");
+    setVersion(panther::TraceSink<double>::VERSION);
+    struct stat st;
+    rows.clear();
+    check((stat(traceFile, &st) == 0) && (truncate(traceFile, st.st_size - 3) == 0) && !convertTrace(traceFile, rows), "truncated trace is rejected");
+    std::remove(traceFile);
+
+    /* other modes compared with the default one on a problem of 4 variables */
+    double x0[4], x1[4];
+    panther::RosenbrockMethod<double> ref;
+    const double v0 = run4(ref, x0);
+    std::cout << "Found v = " << v0 << " for 4 variables in " << ref.getStats().mEvals << " evaluations\n";
+
+    panther::RosenbrockMethod<double, 4> fixed;
+    check(run4(fixed, x1) == v0 && std::equal(x0, x0 + 4, x1), "fixed dimension");
+    bool thrown = false;
+    try {
+        fixed.search(dim, x, a, b, func);
+    } catch (std::invalid_argument& e) {
+        thrown = true;
+    }
+    check(thrown, "fixed dimension rejects another one");
+
+    panther::RosenbrockMethod<double> par;
+    par.getOptions().mParallelTrials = true;
+    check(run4(par, x1) == v0 && std::equal(x0, x0 + 4, x1), "parallel trials");
+
+    /* directions should stay orthonormal after every stage */
+    panther::RosenbrockMethod<double> palmer;
+    palmer.getOptions().mOrtMethod = panther::RosenbrockMethod<double>::PALMER;
+    double maxErr = 0;
+    palmer.getWatchers().push_back([&maxErr](double, const double*, const std::vector<double>& gran, bool, double, double* dirs, int) {
+        const int m = gran.size();
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < m; j++)
+                maxErr = std::max(maxErr, std::abs(snowgoose::VecUtils::vecScalarMult(m, dirs + i * m, dirs + j * m) - (i == j)));
+    });
+    const double vp = run4(palmer, x1);
+    std::cout << "Found with Palmer orthogonalization v = " << vp << ", orthonormality error " << maxErr << "\n";
+    check(std::abs(vp - v0) < 1e-8 && maxErr < 1e-10, "Palmer orthogonalization");
+
+    /* trials along all directions are evaluated at once, a stage is stopped between them */
+    panther::RosenbrockMethod<double> lim;
+    lim.getOptions().mParallelTrials = true;
+    Control ctl;
+    ctl.mMaxEvals = 200;
+    v = run4(lim, x1, func4, &ctl);
+    checkStopped(ctl, Control::BUDGET, 4, v, x1, "budget");
+
+    /* the slow search takes seconds */
+    Control deadline;
+    deadline.setTimeLimit(0.02);
+    v = run4(lim, x1, slow4, &deadline);
+    checkStopped(deadline, Control::DEADLINE, 0, v, x1, "deadline");
+
+    Control cancel;
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cancel.cancel();
+    });
+    v = run4(lim, x1, slow4, &cancel);
+    canceller.join();
+    checkStopped(cancel, Control::CANCELLED, 0, v, x1, "cancelled by another thread");
+
+    return fails ? 1 : 0;
 }
 
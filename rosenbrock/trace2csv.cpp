@@ -0,0 +1,102 @@
+/* 
+ * File:   trace2csv.cpp
+ *
+ * Converts a trace written by TraceSink to CSV.
+ *
+ * Usage: trace2csv.exe trace-file > trace.csv
+ *
+ * Columns: run,stage,value,grad,success,x0..x(n-1),h0..h(n-1)[,d0..d(n*n-1)]
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include "tracesink.hpp"
+
+template <class T> bool readAll(FILE* f, T* p, size_t count) {
+    return fread(p, sizeof (T), count, f) == count;
+}
+
+template <class FT> int convert(FILE* f) {
+    int32_t hdr[4];
+    int header = -1;
+    std::cout.precision(17);
+    while (true) {
+        const size_t got = fread(hdr, sizeof (int32_t), 4, f);
+        if ((got == 0) && feof(f))
+            break;
+        if (got != 4) {
+            std::cerr << "truncated chunk header\n";
+            return 1;
+        }
+        const int run = hdr[0], count = hdr[1], n = hdr[2];
+        const bool dirs = hdr[3];
+        if ((count <= 0) || (n <= 0) || (hdr[3] != 0 && hdr[3] != 1)) {
+            std::cerr << "corrupted chunk header\n";
+            return 1;
+        }
+        const size_t nd = dirs ? (size_t) n * n : 0;
+        std::vector<int32_t> stage(count);
+        std::vector<FT> value(count), grad(count), x((size_t) count * n), gran((size_t) count * n), d(count * nd);
+        std::vector<int8_t> success(count);
+        if (!(readAll(f, stage.data(), count) && readAll(f, value.data(), count) && readAll(f, grad.data(), count)
+                && readAll(f, success.data(), count) && readAll(f, x.data(), x.size()) && readAll(f, gran.data(), gran.size())
+                && readAll(f, d.data(), d.size()))) {
+            std::cerr << "truncated chunk\n";
+            return 1;
+        }
+        if (header != n) {
+            std::cout << "run,stage,value,grad,success";
+            for (int i = 0; i < n; i++)
+                std::cout << ",x" << i;
+            for (int i = 0; i < n; i++)
+                std::cout << ",h" << i;
+            for (size_t i = 0; i < nd; i++)
+                std::cout << ",d" << i;
+            std::cout << "\n";
+            header = n;
+        }
+        for (int k = 0; k < count; k++) {
+            std::cout << run << "," << stage[k] << "," << value[k] << "," << grad[k] << "," << (int) success[k];
+            for (int i = 0; i < n; i++)
+                std::cout << "," << x[(size_t) k * n + i];
+            for (int i = 0; i < n; i++)
+                std::cout << "," << gran[(size_t) k * n + i];
+            for (size_t i = 0; i < nd; i++)
+                std::cout << "," << d[k * nd + i];
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " trace-file\n";
+        return 1;
+    }
+    FILE* f = fopen(argv[1], "rb");
+    if (f == nullptr) {
+        std::cerr << "can't open " << argv[1] << "\n";
+        return 1;
+    }
+    char magic[8];
+    int32_t hdr[2];
+    int rc = 1;
+    if (readAll(f, magic, 8) && readAll(f, hdr, 2) && !memcmp(magic, panther::TraceSink<double>::MAGIC, 8)) {
+        if (hdr[0] != panther::TraceSink<double>::VERSION)
+            std::cerr << "unsupported trace version " << hdr[0] << "\n";
+        else if (hdr[1] == sizeof (double))
+            rc = convert<double>(f);
+        else if (hdr[1] == sizeof (float))
+            rc = convert<float>(f);
+        else
+            std::cerr << "unknown value size " << hdr[1] << "\n";
+    } else {
+        std::cerr << argv[1] << " is not a trace file\n";
+    }
+    fclose(f);
+    return rc;
+}
@@ -0,0 +1,205 @@
+/*
+ * File:   tracesink.hpp
+ *
+ * Binary trace of search stages
+ */
+
+#ifndef TRACESINK_HPP
+#define TRACESINK_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+namespace panther {
+
+    /**
+     * Records search stages (value, gradient estimate, success flag, point, granularity
+     * and optionally directions) into a preallocated ring buffer kept as columns.
+     * If a file is given the buffer is written to it as a chunk every time it is full,
+     * otherwise the buffer keeps the last stages.
+     *
+     * File layout: the header "PNTHRTR" (8 bytes), int32 version, int32 sizeof(FT),
+     * then chunks: int32 run, int32 count, int32 n, int32 1 if directions are recorded,
+     * followed by columns of count entries: int32 stage, FT value, FT gradient estimate,
+     * int8 success, then count * n values of points, count * n values of granularities
+     * and count * n * n values of directions if recorded.
+     * rosenbrock/trace2csv.cpp converts such files to CSV.
+     */
+    template <class FT> class TraceSink {
+    public:
+
+        /**
+         * Constructor
+         * @param capacity the number of stages in the buffer
+         * @param file the trace file (nothing is written if empty)
+         * @param dirs record directions
+         */
+        TraceSink(int capacity, const std::string& file = "", bool dirs = false) :
+        mCapacity(std::max(1, capacity)), mWithDirs(dirs) {
+            if (!file.empty()) {
+                mFile = fopen(file.c_str(), "wb");
+                if (mFile == nullptr)
+                    throw std::runtime_error("can't open " + file + ": " + strerror(errno));
+                const int32_t hdr[2] = {VERSION, sizeof (FT)};
+                if ((fwrite(MAGIC, 1, 8, mFile) != 8) || (fwrite(hdr, sizeof (int32_t), 2, mFile) != 2)) {
+                    fclose(mFile);
+                    throw std::runtime_error("can't write " + file + ": " + strerror(errno));
+                }
+                mName = file;
+            }
+            mStage.resize(mCapacity);
+            mValue.resize(mCapacity);
+            mGrad.resize(mCapacity);
+            mSuccess.resize(mCapacity);
+        }
+
+        TraceSink(const TraceSink&) = delete;
+        TraceSink& operator=(const TraceSink&) = delete;
+
+        ~TraceSink() {
+            if (mFile != nullptr) {
+                try {
+                    flush();
+                } catch (std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                }
+                if (fclose(mFile) != 0)
+                    std::cerr << "can't write " << mName << ": " << strerror(errno) << std::endl;
+            }
+        }
+
+        /**
+         * Starts a new run (called by the solver at the beginning of a search)
+         * @param n the number of variables
+         */
+        void begin(int n) {
+            flush();
+            if (n != mN) {
+                mN = n;
+                mX.resize((size_t) mCapacity * n);
+                mGran.resize((size_t) mCapacity * n);
+                if (mWithDirs)
+                    mDirs.resize((size_t) mCapacity * n * n);
+            }
+            mRun++;
+            mCount = 0;
+            mHead = 0;
+        }
+
+        /**
+         * Records a stage
+         * @param stage the stage number
+         * @param fval the current value
+         * @param success true if the stage was successful
+         * @param grad the gradient estimate
+         * @param x the current point
+         * @param gran the granularity vector
+         * @param dirs the directions (n * n)
+         */
+        void record(int stage, FT fval, bool success, FT grad, const FT* x, const FT* gran, const FT* dirs) {
+            if ((mCount == mCapacity) && (mFile != nullptr))
+                flush();
+            const int k = (mHead + mCount) % mCapacity;
+            mStage[k] = stage;
+            mValue[k] = fval;
+            mGrad[k] = grad;
+            mSuccess[k] = success;
+            std::copy(x, x + mN, mX.data() + (size_t) k * mN);
+            std::copy(gran, gran + mN, mGran.data() + (size_t) k * mN);
+            if (mWithDirs)
+                std::copy(dirs, dirs + mN * mN, mDirs.data() + (size_t) k * mN * mN);
+            if (mCount < mCapacity)
+                mCount++;
+            else
+                mHead = (mHead + 1) % mCapacity;
+        }
+
+        /* writes buffered stages to the file, throws std::runtime_error if the file can't be written (e.g. the disk is full) */
+        void flush() {
+            if ((mFile == nullptr) || (mCount == 0))
+                return;
+            /* in the file mode the buffer is flushed before it wraps so it starts from zero */
+            const int32_t hdr[4] = {mRun, mCount, mN, mWithDirs};
+            const size_t cn = (size_t) mCount * mN;
+            const bool ok = (fwrite(hdr, sizeof (int32_t), 4, mFile) == 4)
+                    && (fwrite(mStage.data(), sizeof (int32_t), mCount, mFile) == (size_t) mCount)
+                    && (fwrite(mValue.data(), sizeof (FT), mCount, mFile) == (size_t) mCount)
+                    && (fwrite(mGrad.data(), sizeof (FT), mCount, mFile) == (size_t) mCount)
+                    && (fwrite(mSuccess.data(), 1, mCount, mFile) == (size_t) mCount)
+                    && (fwrite(mX.data(), sizeof (FT), cn, mFile) == cn)
+                    && (fwrite(mGran.data(), sizeof (FT), cn, mFile) == cn)
+                    && (!mWithDirs || (fwrite(mDirs.data(), sizeof (FT), cn * mN, mFile) == cn * mN))
+                    && (fflush(mFile) == 0);
+            mCount = 0;
+            mHead = 0;
+            if (!ok)
+                throw std::runtime_error("can't write " + mName + ": " + strerror(errno));
+        }
+
+        /* the number of buffered stages */
+        int size() const {
+            return mCount;
+        }
+
+        /* the stage number of the k-th buffered stage (the oldest first) */
+        int stage(int k) const {
+            return mStage[slot(k)];
+        }
+
+        FT value(int k) const {
+            return mValue[slot(k)];
+        }
+
+        FT grad(int k) const {
+            return mGrad[slot(k)];
+        }
+
+        bool success(int k) const {
+            return mSuccess[slot(k)];
+        }
+
+        const FT* x(int k) const {
+            return mX.data() + (size_t) slot(k) * mN;
+        }
+
+        const FT* gran(int k) const {
+            return mGran.data() + (size_t) slot(k) * mN;
+        }
+
+        /* directions of the k-th buffered stage, nullptr if they are not recorded */
+        const FT* dirs(int k) const {
+            return mWithDirs ? mDirs.data() + (size_t) slot(k) * mN * mN : nullptr;
+        }
+
+        static constexpr const char* MAGIC = "PNTHRTR";
+        static constexpr int32_t VERSION = 1;
+
+    private:
+
+        int slot(int k) const {
+            return (mHead + k) % mCapacity;
+        }
+
+        int mCapacity;
+        bool mWithDirs;
+        FILE* mFile = nullptr;
+        std::string mName;
+        int mN = 0;
+        int mRun = 0;
+        int mCount = 0;
+        int mHead = 0;
+        std::vector<int32_t> mStage;
+        std::vector<FT> mValue, mGrad;
+        std::vector<int8_t> mSuccess;
+        std::vector<FT> mX, mGran, mDirs;
+    };
+}
+
+#endif /* TRACESINK_HPP */